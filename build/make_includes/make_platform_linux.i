@@ -58,5 +58,5 @@ EXEPPDEFS = -pthread -L$(LIB_DIR) $(ARCHITECTURE)
 LIBDEFS   = qc
 DLLDEFS   = -shared -pthread -fPIC -L$(LIB_DIR) $(ARCHITECTURE)
 
-OS_LIBS   = -lm -lpthread
-OS_LIBSPP = -lm -lpthread -lstdc++
+OS_LIBS   = -lm -lpthread -lrt
+OS_LIBSPP = -lm -lpthread -lrt -lstdc++
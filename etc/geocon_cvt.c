@@ -40,16 +40,19 @@ static const char *    separator   = " ";                /* -s str         */
 
 static GEOCON_BOOL     direction   = GEOCON_CVT_FORWARD; /* -f | -i        */
 static GEOCON_BOOL     reversed    = FALSE;              /* -r             */
-static GEOCON_BOOL     read_on_fly = FALSE;              /* -d             */
+static int             load_mode   = GEOCON_LOAD_DATA;   /* -d|-m|-z|-P    */
+static GEOCON_BOOL     attach      = FALSE;              /* -a             */
 static GEOCON_BOOL     round_trip  = FALSE;              /* -R             */
 static GEOCON_BOOL     interp_all  = FALSE;              /* -A             */
 static GEOCON_BOOL     do_8086     = FALSE;              /* -k             */
+static GEOCON_BOOL     coefs       = FALSE;              /* -X             */
 
 static GEOCON_EXTENT   extent      = { 0 };              /* -e ...         */
 static GEOCON_EXTENT * extptr      = GEOCON_NULL;        /* -e ...         */
 
 static double          deg_factor  = 1.0;                /* -c deg-factor  */
 static double          hgt_factor  = 1.0;                /* -h hgt-factor  */
+static double          cache_kb    = 0.0;                /* -t cache-size  */
 
 static int             interp      = GEOCON_INTERP_DEFAULT;
                                                          /* -L, -C, -Q, -N */
@@ -160,6 +163,12 @@ static void display_usage(int level)
                            "(lon lat hgt) instead of (lat lon hgt)\n");
       printf("  -k         Read and write *80*/*86* records\n");
       printf("  -d         Read shift data on the fly (no load of data)\n");
+      printf("  -m         Map  shift data into memory (if possible)\n");
+      printf("  -z         Load shift data as 16-bit values "
+                           "(shows max errors)\n");
+      printf("  -P         Load shift data as planes of lat, lon, hgt values\n");
+      printf("  -a         Attach to shift data in shared memory "
+                           "(filename is its name)\n");
       printf("  -f         Forward transformation           (default)\n");
       printf("  -i         Inverse transformation\n");
       printf("  -R         Do round trip\n");
@@ -170,6 +179,7 @@ static void display_usage(int level)
       printf("  -N         Use natural spline interpolation\n");
       printf("  -Q         Use biquadratic    interpolation (default)\n");
       printf("  -A         Use all interpolation methods\n");
+      printf("  -X         Precompute bicubic coefficients (uses more memory)\n");
       printf("\n");
 
       printf("  -c value   Conversion: degrees-per-unit     "
@@ -180,6 +190,8 @@ static void display_usage(int level)
                            "(default is \" \")\n");
       printf("  -p file    Read points from file            "
                            "(default is \"-\" or stdin)\n");
+      printf("  -t value   Tile cache size in KB when reading on the fly "
+                           "(-d)\n");
       printf("  -e slat wlon nlat elon   Specify an extent\n");
       printf("\n");
 
@@ -189,10 +201,10 @@ static void display_usage(int level)
    else
    {
       fprintf(stderr,
-         "Usage: %s [-r] [-k] [-d] [-f|-i] [-R] [-L|-C|-N|-Q|-A]\n",
+         "Usage: %s [-r] [-k] [-d|-m|-z|-P|-a] [-f|-i] [-R] [-L|-C|-N|-Q|-A] [-X]\n",
          pgm);
       fprintf(stderr,
-         "       %*s [-c value] [-h value] [-s string] [-p file]\n",
+         "       %*s [-c value] [-h value] [-s string] [-p file] [-t value]\n",
          (int)strlen(pgm), "");
       fprintf(stderr,
          "       %*s [-e slat wlon nlat elon]\n",
@@ -243,7 +255,11 @@ static int process_options(int argc, const char **argv)
       else if ( strcmp(arg, "i") == 0 ) direction   = GEOCON_CVT_INVERSE;
       else if ( strcmp(arg, "k") == 0 ) do_8086     = TRUE;
       else if ( strcmp(arg, "r") == 0 ) reversed    = TRUE;
-      else if ( strcmp(arg, "d") == 0 ) read_on_fly = TRUE;
+      else if ( strcmp(arg, "d") == 0 ) load_mode   = GEOCON_LOAD_NONE;
+      else if ( strcmp(arg, "m") == 0 ) load_mode   = GEOCON_LOAD_MAPPED;
+      else if ( strcmp(arg, "z") == 0 ) load_mode   = GEOCON_LOAD_COMPACT;
+      else if ( strcmp(arg, "P") == 0 ) load_mode   = GEOCON_LOAD_PLANAR;
+      else if ( strcmp(arg, "a") == 0 ) attach      = TRUE;
       else if ( strcmp(arg, "R") == 0 ) round_trip  = TRUE;
 
       else if ( strcmp(arg, "A") == 0 ) interp_all  = TRUE;
@@ -251,6 +267,7 @@ static int process_options(int argc, const char **argv)
       else if ( strcmp(arg, "C") == 0 ) interp      = GEOCON_INTERP_BICUBIC;
       else if ( strcmp(arg, "Q") == 0 ) interp      = GEOCON_INTERP_BIQUADRATIC;
       else if ( strcmp(arg, "N") == 0 ) interp      = GEOCON_INTERP_NATSPLINE;
+      else if ( strcmp(arg, "X") == 0 ) coefs       = TRUE;
 
       else if ( strcmp(arg, "s") == 0 )
       {
@@ -288,6 +305,18 @@ static int process_options(int argc, const char **argv)
          hgt_factor = atof( argv[optcnt] );
       }
 
+      else if ( strcmp(arg, "t") == 0 )
+      {
+         if ( ++optcnt >= argc )
+         {
+            fprintf(stderr, "%s: option needs an argument -- -%s\n",
+               pgm, "t");
+            display_usage(0);
+            exit(EXIT_FAILURE);
+         }
+         cache_kb = atof( argv[optcnt] );
+      }
+
       else if ( strcmp(arg, "p") == 0 )
       {
          if ( ++optcnt >= argc )
@@ -916,11 +945,20 @@ int main(int argc, const char **argv)
    /*---------------------------------------------------------
     * Load the file.
     */
-   hdr = geocon_load(
-      filename,           /* in:  name             */
-      extptr,             /* in:  extent pointer?  */
-      !read_on_fly,       /* in:  read shift data? */
-      &gcerr);            /* out: result code      */
+   if ( attach )
+   {
+      hdr = geocon_attach(
+         filename,        /* in:  segment name     */
+         &gcerr);         /* out: result code      */
+   }
+   else
+   {
+      hdr = geocon_load(
+         filename,        /* in:  name             */
+         extptr,          /* in:  extent pointer?  */
+         load_mode,       /* in:  load mode        */
+         &gcerr);         /* out: result code      */
+   }
 
    if ( hdr == GEOCON_NULL )
    {
@@ -932,6 +970,53 @@ int main(int argc, const char **argv)
       return EXIT_FAILURE;
    }
 
+   /*---------------------------------------------------------
+    * Show the errors of a compact load.
+    */
+   if ( !attach && load_mode == GEOCON_LOAD_COMPACT )
+   {
+      fprintf(stderr, "%s: %s: max errors: lat %.3g lon %.3g (deg) "
+                      "hgt %.3g (m)\n",
+         pgm, filename,
+         hdr->quant.max_err[GEOCON_QUANT_LAT] / hdr->horz_scale,
+         hdr->quant.max_err[GEOCON_QUANT_LON] / hdr->horz_scale,
+         hdr->quant.max_err[GEOCON_QUANT_HGT] / hdr->vert_scale);
+   }
+
+   /*---------------------------------------------------------
+    * Set up any tile cache.
+    */
+   if ( cache_kb > 0 )
+   {
+      rc = geocon_set_cache(hdr, (size_t)(cache_kb * 1024), &gcerr);
+      if ( rc != 0 )
+      {
+         char msg_buf[GEOCON_MAX_ERR_LEN];
+
+         fprintf(stderr, "%s: %s: %s\n",
+            pgm, filename, geocon_errmsg(gcerr, msg_buf));
+         geocon_delete(hdr);
+         return EXIT_FAILURE;
+      }
+   }
+
+   /*---------------------------------------------------------
+    * Set up any bicubic coefficients.
+    */
+   if ( coefs )
+   {
+      rc = geocon_set_coefs(hdr, TRUE, &gcerr);
+      if ( rc != 0 )
+      {
+         char msg_buf[GEOCON_MAX_ERR_LEN];
+
+         fprintf(stderr, "%s: %s: %s\n",
+            pgm, filename, geocon_errmsg(gcerr, msg_buf));
+         geocon_delete(hdr);
+         return EXIT_FAILURE;
+      }
+   }
+
    /*---------------------------------------------------------
     * Either process lon/lat/hgt triples from the cmd line or
     * process all points in the input file.
@@ -34,14 +34,21 @@
  */
 static const char *    pgm       = GEOCON_NULL;
 static const char *    outfile   = GEOCON_NULL;            /* -o file      */
+static const char *    shmname   = GEOCON_NULL;            /* -p name      */
 
 static GEOCON_BOOL     dump_hdr  = FALSE;                  /* -h           */
 static GEOCON_BOOL     list_hdr  = FALSE;                  /* -l           */
 static GEOCON_BOOL     dump_data = FALSE;                  /* -d           */
-static GEOCON_BOOL     read_data = FALSE;                  /* -d | -o file */
+static GEOCON_BOOL     read_data = FALSE;                  /* -d | -o | -p */
 static GEOCON_EXTENT   extent    = { 0 };                  /* -e ...       */
 static GEOCON_EXTENT * extptr    = GEOCON_NULL;            /* -e ...       */
 static int             endian    = GEOCON_ENDIAN_INP_FILE; /* -B | -L | -N */
+static GEOCON_BOOL     quantize  = FALSE;                  /* -q ...       */
+static double          horz_err  = 0.0;                    /* -q ...       */
+static double          vert_err  = 0.0;                    /* -q ...       */
+static GEOCON_BOOL     packed    = FALSE;                  /* -z           */
+static GEOCON_BOOL     tiled     = FALSE;                  /* -t size      */
+static int             tile_size = 0;                      /* -t size      */
 
 static GEOCON_BOOL     do_title  = TRUE;
 
@@ -66,18 +73,24 @@ static void display_usage(int level)
       printf("  -L         Write little-endian binary file\n");
       printf("  -N         Write native-endian binary file\n");
       printf("             (default is same as input  file)\n");
+      printf("  -q herr verr   Write quantized binary file with max errors\n");
+      printf("                 (degrees and meters, 0 = as exact as floats)\n");
+      printf("  -z         Write packed (compressed) binary file\n");
+      printf("  -t size    Write tiled binary file with size x size tiles\n");
+      printf("             (0 = default size, -z also compresses tiles)\n");
       printf("\n");
 
       printf("  -o file    Specify output file\n");
+      printf("  -p name    Publish data to named shared memory\n");
       printf("  -e slat wlon nlat elon   Specify extent\n");
    }
    else
    {
       fprintf(stderr,
-         "Usage: %s [-h|-l] [-d] [-B|-L|-N] [-o file]\n",
+         "Usage: %s [-h|-l] [-d] [-B|-L|-N] [-q herr verr|-z] [-t size]\n",
          pgm);
       fprintf(stderr,
-         "       %*s [-e slat wlon nlat elon] file ...\n",
+         "       %*s [-o file] [-p name] [-e slat wlon nlat elon] file ...\n",
          (int)strlen(pgm), "");
    }
 }
@@ -119,6 +132,7 @@ static int process_options(int argc, const char **argv)
       else if ( strcmp(arg, "B") == 0 ) endian     = GEOCON_ENDIAN_BIG;
       else if ( strcmp(arg, "L") == 0 ) endian     = GEOCON_ENDIAN_LITTLE;
       else if ( strcmp(arg, "N") == 0 ) endian     = GEOCON_ENDIAN_NATIVE;
+      else if ( strcmp(arg, "z") == 0 ) packed     = TRUE;
 
       else if ( strcmp(arg, "o") == 0 )
       {
@@ -132,6 +146,45 @@ static int process_options(int argc, const char **argv)
          outfile   = argv[optcnt];
       }
 
+      else if ( strcmp(arg, "p") == 0 )
+      {
+         if ( ++optcnt >= argc )
+         {
+            fprintf(stderr, "%s: option needs an argument -- -%s\n",
+               pgm, "p");
+            display_usage(0);
+            exit(EXIT_FAILURE);
+         }
+         shmname   = argv[optcnt];
+      }
+
+      else if ( strcmp(arg, "t") == 0 )
+      {
+         if ( ++optcnt >= argc )
+         {
+            fprintf(stderr, "%s: option needs an argument -- -%s\n",
+               pgm, "t");
+            display_usage(0);
+            exit(EXIT_FAILURE);
+         }
+         tile_size = atoi( argv[optcnt] );
+         tiled     = TRUE;
+      }
+
+      else if ( strcmp(arg, "q") == 0 )
+      {
+         if ( (optcnt+2) >= argc )
+         {
+            fprintf(stderr, "%s: option needs 2 arguments -- -%s\n",
+               pgm, "q");
+            display_usage(0);
+            exit(EXIT_FAILURE);
+         }
+         horz_err = atof( argv[++optcnt] );
+         vert_err = atof( argv[++optcnt] );
+         quantize = TRUE;
+      }
+
       else if ( strcmp(arg, "e") == 0 )
       {
          if ( (optcnt+4) >= argc )
@@ -156,7 +209,8 @@ static int process_options(int argc, const char **argv)
       }
    }
 
-   read_data = ( dump_data || (outfile != GEOCON_NULL) );
+   read_data = ( dump_data || (outfile != GEOCON_NULL) ||
+                              (shmname != GEOCON_NULL) );
 
    if ( argc == optcnt )
    {
@@ -179,13 +233,26 @@ static int process_options(int argc, const char **argv)
       dump_data = FALSE;
    }
 
+   if ( quantize && packed )
+   {
+      fprintf(stderr, "%s: Both -q and -z specified. -z ignored.\n", pgm);
+      packed    = FALSE;
+   }
+
+   if ( quantize && tiled )
+   {
+      fprintf(stderr, "%s: Both -q and -t specified. -t ignored.\n", pgm);
+      tiled     = FALSE;
+   }
+
    if ( outfile != GEOCON_NULL && dump_data )
    {
       fprintf(stderr, "%s: Both -o and -d specified. -d ignored.\n", pgm);
       dump_data = FALSE;
    }
 
-   if ( outfile != GEOCON_NULL && (optcnt+1) < argc )
+   if ( (outfile != GEOCON_NULL || shmname != GEOCON_NULL) &&
+        (optcnt+1) < argc )
    {
       fprintf(stderr, "%s: Too many files specified.\n",
          pgm);
@@ -231,7 +298,18 @@ static int process_file(const char *inpfile)
 
    if ( outfile != GEOCON_NULL )
    {
-      rc = geocon_write(hdr, outfile, endian, &gcerr);
+      if ( quantize )
+         rc = geocon_write_quant(hdr, outfile, endian,
+                                 horz_err, vert_err, &gcerr);
+      else
+      if ( tiled )
+         rc = geocon_write_tiled(hdr, outfile, endian,
+                                 tile_size, packed, &gcerr);
+      else
+      if ( packed )
+         rc = geocon_write_packed(hdr, outfile, endian, &gcerr);
+      else
+         rc = geocon_write(hdr, outfile, endian, &gcerr);
       if ( rc != GEOCON_ERR_OK )
       {
          char msg_buf[GEOCON_MAX_ERR_LEN];
@@ -240,6 +318,19 @@ static int process_file(const char *inpfile)
       }
    }
 
+   /* Publish it if requested. */
+
+   if ( shmname != GEOCON_NULL && rc == GEOCON_ERR_OK )
+   {
+      rc = geocon_publish(hdr, shmname, &gcerr);
+      if ( rc != GEOCON_ERR_OK )
+      {
+         char msg_buf[GEOCON_MAX_ERR_LEN];
+         printf("%s: Cannot publish data: %s\n",
+            shmname, geocon_errmsg(gcerr, msg_buf));
+      }
+   }
+
    geocon_delete(hdr);
    return (rc == GEOCON_ERR_OK) ? 0 : -1;
 }
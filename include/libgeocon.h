@@ -53,6 +53,12 @@ extern "C" {
 typedef int                GEOCON_BOOL;        /*!< Boolean variable        */
 typedef double             GEOCON_COORD [2];   /*!< Lon/lat coordinate      */
 
+#if defined(_MSC_VER)
+typedef __int64            GEOCON_OFFSET;      /*!< 64-bit file offset      */
+#else
+typedef long long          GEOCON_OFFSET;      /*!< 64-bit file offset      */
+#endif
+
 #define GEOCON_COORD_LON         0             /*!< Longitude coord index   */
 #define GEOCON_COORD_LAT         1             /*!< Latitude  coord index   */
 
@@ -65,7 +71,8 @@ typedef double             GEOCON_COORD [2];   /*!< Lon/lat coordinate      */
 #define GEOCON_HDR_MAGIC          0x47434f4e    /*!< "GCON" (not swapped)   */
 #define GEOCON_HDR_MAGIC_SWAPPED  0x4e4f4347    /*!< "NOCG" (    swapped)   */
 
-#define GEOCON_HDR_VERSION        1
+#define GEOCON_HDR_VERSION        1   /*!< Header version (float data)  */
+#define GEOCON_HDR_VERSION_2      2   /*!< Header version (other data)  */
 
 #define GEOCON_HDR_INFO_LEN      80   /*!< Max length of info field         */
 #define GEOCON_HDR_DATE_LEN      24   /*!< Max length of date field         */
@@ -88,6 +95,17 @@ typedef double             GEOCON_COORD [2];   /*!< Lon/lat coordinate      */
 #define GEOCON_FILE_TYPE_BIN      1   /*!< File type is binary              */
 #define GEOCON_FILE_TYPE_ASC      2   /*!< File type is ascii               */
 
+/* data formats (and flags) */
+
+#define GEOCON_DATA_FLOAT     0x000   /*!< Points are floats                */
+#define GEOCON_DATA_QUANT     0x001   /*!< Points are scaled integers       */
+#define GEOCON_DATA_FMT_MASK  0x0ff   /*!< Mask for the format of points    */
+
+#define GEOCON_DATA_PACKED    0x100   /*!< Points are in compressed blocks  */
+#define GEOCON_DATA_TILED     0x200   /*!< Points are in tiles              */
+
+#define GEOCON_TILE_SIZE         64   /*!< Default rows & cols in a tile    */
+
 /* output byte-order options */
 
 #define GEOCON_ENDIAN_INP_FILE    0   /*!< Write input-file    byte-order   */
@@ -95,6 +113,14 @@ typedef double             GEOCON_COORD [2];   /*!< Lon/lat coordinate      */
 #define GEOCON_ENDIAN_LITTLE      2   /*!< Write little-endian byte-order   */
 #define GEOCON_ENDIAN_NATIVE      3   /*!< Write native        byte-order   */
 
+/* data load modes */
+
+#define GEOCON_LOAD_NONE          0   /*!< Read data on-the-fly from file   */
+#define GEOCON_LOAD_DATA          1   /*!< Read data into memory            */
+#define GEOCON_LOAD_MAPPED        2   /*!< Map  data into memory if we can  */
+#define GEOCON_LOAD_COMPACT       3   /*!< Read data into memory as int16s  */
+#define GEOCON_LOAD_PLANAR        4   /*!< Read data into memory as planes  */
+
 /* interpolation types */
 
 #define GEOCON_INTERP_DEFAULT     0   /*!< Use default        interpolation */
@@ -122,7 +148,7 @@ struct geocon_file_hdr
    int           magic;            /*!< Magic number                         */
    int           version;          /*!< Header version                       */
    int           hdrlen;           /*!< Header length                        */
-   int           reserved;         /*!< Reserved - should be 0               */
+   int           data_fmt;         /*!< Data format & flags (GEOCON_DATA_*)  */
 
    char          info  [GEOCON_HDR_INFO_LEN];  /*!< File description         */
    char          source[GEOCON_HDR_INFO_LEN];  /*!< Source of this data      */
@@ -173,6 +199,78 @@ struct geocon_point
    float         hgt_value;          /*!< Height    shift or error value     */
 };
 
+/*---------------------------------------------------------------------------*/
+/**
+ * GEOCON quantization info
+ *
+ * <p>In a binary file whose data format is GEOCON_DATA_QUANT, this follows
+ * the file header, and each point is stored as three scaled integers
+ * (lat, lon, and hgt values, in that order, with no padding).  Each
+ * component is either 2 or 4 bytes, and its value is (base + (q * step)),
+ * in the same units as the values of a GEOCON_POINT.
+ *
+ * <p>The max error is the largest difference between a value and its
+ * quantized value that was found when the file was written.
+ */
+#define GEOCON_QUANT_LAT          0   /*!< Latitude  component index        */
+#define GEOCON_QUANT_LON          1   /*!< Longitude component index        */
+#define GEOCON_QUANT_HGT          2   /*!< Height    component index        */
+
+typedef struct geocon_quant GEOCON_QUANT;
+struct geocon_quant
+{
+   int           size[3];          /*!< Bytes per component (2 or 4)         */
+   int           reserved;         /*!< Reserved - should be 0               */
+   double        base[3];          /*!< Value of a component of 0            */
+   double        step[3];          /*!< Value of one unit of a component     */
+   double        max_err[3];       /*!< Max error of a component             */
+};
+
+/*---------------------------------------------------------------------------*/
+/**
+ * GEOCON block index
+ *
+ * <p>In a binary file whose data format includes GEOCON_DATA_PACKED, this
+ * follows the file header (and any quantization info), and is followed
+ * by (nblocks + 1) 64-bit file offsets, the first nblocks of which are
+ * the offsets of the blocks, and the last of which is the end of the last
+ * block.
+ *
+ * <p>Each block holds block_rows rows of points (the last may hold fewer),
+ * in file order, which are compressed as one unit.  Thus any row can be
+ * read by decompressing just its block.
+ */
+typedef struct geocon_block_hdr GEOCON_BLOCK_HDR;
+struct geocon_block_hdr
+{
+   int           block_rows;       /*!< Number of rows in a block            */
+   int           nblocks;          /*!< Number of blocks                     */
+};
+
+/*---------------------------------------------------------------------------*/
+/**
+ * GEOCON tile directory
+ *
+ * <p>In a binary file whose data format includes GEOCON_DATA_TILED, this
+ * takes the place of the block index (GEOCON_BLOCK_HDR), and is followed
+ * by (ntiles + 1) 64-bit file offsets in the same way.
+ *
+ * <p>Each tile holds tile_rows rows of tile_cols points, in file order
+ * (the tiles in the last row and column of tiles may hold fewer), and the
+ * tiles are numbered across each row of tiles, and then up the rows of
+ * tiles, in file order.  Thus any small area can be read by reading just
+ * the few tiles it is in.  If the data format also includes
+ * GEOCON_DATA_PACKED, each tile is compressed as one unit.
+ */
+typedef struct geocon_tile_hdr GEOCON_TILE_HDR;
+struct geocon_tile_hdr
+{
+   int           tile_rows;        /*!< Number of rows    in a tile          */
+   int           tile_cols;        /*!< Number of columns in a tile          */
+   int           ntiles;           /*!< Number of tiles                      */
+   int           reserved;         /*!< Reserved - should be 0               */
+};
+
 /*---------------------------------------------------------------------------*/
 /**
  * GEOCON internal header
@@ -186,7 +284,7 @@ struct geocon_hdr
    int           filetype;         /*!< File type (binary or ascii)          */
 
    GEOCON_BOOL   flip;             /*!< TRUE to byte-swap data               */
-   long          points_start;     /*!< Offset to start of points in file    */
+   GEOCON_OFFSET points_start;     /*!< Offset to start of points in file    */
    int           line_count;       /*!< Line count when reading ascii file   */
 
    /* These values may be different from the file header if
@@ -214,6 +312,13 @@ struct geocon_hdr
    double        horz_scale;       /*!< Horizontal units per degree          */
    double        vert_scale;       /*!< Vertical   units per meter           */
 
+   /* This is how the points are stored, both in the file and in memory.
+      If they are quantized, the points array is null, and the qpoints
+      array is used instead.
+   */
+   int           data_fmt;         /*!< Data format (GEOCON_DATA_FLOAT/QUANT)*/
+   GEOCON_QUANT  quant;            /*!< Quantization info if quantized       */
+
    /* Values for "phantom cells" around our grid. */
    double        lat_min_ghost;    /*!< South latitude  of minus 1 cell      */
    double        lat_max_ghost;    /*!< North latitude  of plus  1 cell      */
@@ -226,14 +331,63 @@ struct geocon_hdr
    /* This should be used if mutex control is needed
       for multi-threaded access to the file when
       transforming points and reading data on-the-fly.
+      Data is read with positional reads, which need no
+      lock, so this is only used if the OS can't do them.
       This mutex does not need to be recursive.
    */
    void *        mutex;            /*!< MUTEX for reading                    */
 
+   /* If reading data on the fly, this may be a cache of tiles of the
+      data, set by geocon_set_cache().  It is private to the library.
+   */
+   void *        cache;            /*!< Tile cache for reading or null       */
+
+   /* If reading a packed file on the fly (or while loading it), this is
+      its block index and a cache of blocks.  It is private to the library.
+   */
+   void *        blocks;           /*!< Block state for reading or null      */
+
    /* If reading data on the fly, this is null.
       This array is always stored with points going from SW to NE.
    */
    GEOCON_POINT *points;           /*!< Array of (nrows x ncols) points      */
+
+   /* If reading data on the fly or if the data is not quantized, this is
+      null.  Otherwise, it is the same as the points array, but with each
+      point stored as described by the quantization info, in native
+      byte-order.
+   */
+   void *        qpoints;          /*!< Array of (nrows x ncols) quantized
+                                        points                               */
+
+   /* If the data was loaded as planes, the points and qpoints arrays are
+      null, and this is three arrays of (nrows x ncols) values, the lat
+      values, then the lon values, then the hgt values, each stored in
+      the same order as the points array.
+   */
+   float *       planes;           /*!< Lat, lon, & hgt planes or null       */
+
+   /* If set by geocon_set_coefs(), this is the bicubic polynomial of
+      each cell of the grid (including the phantom cells around it).
+      It is private to the library.
+   */
+   double *      coefs;            /*!< Bicubic coefficients or null         */
+
+   /* If the data was mapped into memory, this is the mapping of the
+      file, and the points array points into it (and is read-only).
+   */
+   void *        map_addr;         /*!< Address of file mapping or null      */
+   size_t        map_len;          /*!< Length  of file mapping              */
+
+   /* If the data is being loaded asynchronously, this is the state of
+      the load.  It is private to the library.
+   */
+   void *        loader;           /*!< Asynchronous load state or null      */
+
+   /* If the object was opened by geocon_open(), this is its entry in the
+      registry of shared objects.  It is private to the library.
+   */
+   void *        entry;            /*!< Registry entry or null               */
 };
 
 /*---------------------------------------------------------------------------*/
@@ -279,6 +433,9 @@ struct geocon_extent
 #define GEOCON_ERR_UNKNOWN_FILETYPE    8
 #define GEOCON_ERR_UNEXPECTED_EOF      9
 #define GEOCON_ERR_INVALID_TOKEN_CNT  10
+#define GEOCON_ERR_NO_DATA            11
+#define GEOCON_ERR_NOT_SUPPORTED      12
+#define GEOCON_ERR_QUANT_ERROR        13
 
 /*---------------------------------------------------------------------------*/
 /* GEOCON routines                                                           */
@@ -340,9 +497,40 @@ extern GEOCON_HDR * geocon_create();
  *                   This pointer may be NULL.
  *                   This is ignored for ascii files.
  *
- * @param load_data  TRUE to read shift data into memory.
- *                   A TRUE value will also result in closing the file
- *                   after reading, since there is no need to keep it open.
+ * @param load_data  How to load the shift data:
+ *                   <ul>
+ *                     <li>GEOCON_LOAD_NONE   (FALSE) Read data on-the-fly
+ *                     <li>GEOCON_LOAD_DATA   (TRUE)  Read data into memory
+ *                     <li>GEOCON_LOAD_MAPPED         Map  data into memory
+ *                     <li>GEOCON_LOAD_COMPACT        Read data into memory
+ *                                                    as 16-bit values
+ *                     <li>GEOCON_LOAD_PLANAR         Read data into memory
+ *                                                    as planes
+ *                   </ul>
+ *                   Loading or mapping the data will also result in
+ *                   closing the file after reading, since there is no
+ *                   need to keep it open.
+ *
+ *                   <p>A mapped file is shared (via the OS page cache)
+ *                   between all processes that map it, and the points
+ *                   array is then read-only.  Only a native-endian binary
+ *                   file with its data going S-N and W-E can be mapped,
+ *                   and only if no extent is given and the file is not
+ *                   packed or tiled.  Otherwise, the data is just read
+ *                   into memory.
+ *
+ *                   <p>A compact load stores each value as a scaled
+ *                   16-bit integer (see GEOCON_QUANT), which takes half
+ *                   the memory of floats, and the values are widened as
+ *                   they are used.  The max error this causes for each
+ *                   component is then in hdr->quant.max_err (in the
+ *                   units of a GEOCON_POINT).
+ *
+ *                   <p>A planar load stores the lat, lon, and hgt values
+ *                   in three separate arrays (see hdr->planes), so that
+ *                   the values of one component of neighboring points
+ *                   are next to each other.  It takes the same memory as
+ *                   a normal load.
  *
  * @param prc        A pointer to a result code.
  *                   This pointer may be NULL.
@@ -356,7 +544,287 @@ extern GEOCON_HDR * geocon_create();
 extern GEOCON_HDR * geocon_load(
    const char    *pathname,
    GEOCON_EXTENT *extent,
-   GEOCON_BOOL    load_data,
+   int            load_data,
+   int           *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Open a shared GEOCON object.
+ *
+ * <p>This is the same as geocon_load(), except that the object is kept
+ * in a process-wide registry, and opening the same file again with the
+ * same extent and load mode returns the same object rather than loading
+ * another copy.  Files are matched by their canonical pathname, so
+ * different names for the same file match.  A pathname that can't be
+ * resolved (or whose canonical form is too long) is an error.
+ *
+ * <p>Each successful open adds a reference to the object, and each
+ * geocon_delete() of it drops one.  The object is deleted when the last
+ * reference is dropped.
+ *
+ * <p>Since the object is shared, it must be treated as read-only
+ * (including not changing its tile cache).
+ *
+ * @param pathname   The name of the GEOCON file to load.
+ *
+ * @param extent     A pointer to an GEOCON_EXTENT struct.
+ *                   This pointer may be NULL.
+ *                   This is ignored for ascii files.
+ *
+ * @param load_data  How to load the shift data (see geocon_load()).
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           A pointer to a GEOCON object or NULL if unsuccessful.
+ */
+extern GEOCON_HDR * geocon_open(
+   const char    *pathname,
+   GEOCON_EXTENT *extent,
+   int            load_data,
+   int           *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Start loading a GEOCON file into memory in the background.
+ *
+ * <p>This is the same as geocon_load(), except that only the header is
+ * read before returning, and the data is then loaded by a separate thread.
+ * The load can be checked with geocon_load_done() or waited for with
+ * geocon_load_wait().
+ *
+ * <p>Until the load is done, the file header (hdr->fhdr) may be examined,
+ * but the rest of the object belongs to the loading thread.
+ * Any transformation done before then will not transform any points,
+ * and geocon_write(), geocon_dump_data(), and geocon_delete() will wait
+ * for the load to finish.
+ *
+ * <p>If the data is to be read on-the-fly, or if a thread cannot be
+ * started, the load is just done before returning.
+ *
+ * @param pathname   The name of the GEOCON file to load.
+ *
+ * @param extent     A pointer to an GEOCON_EXTENT struct.
+ *                   This pointer may be NULL.
+ *                   This is ignored for ascii files.
+ *
+ * @param load_data  How to load the shift data (see geocon_load()).
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *                   Note that this only reflects loading the header.
+ *
+ * @return           A pointer to a GEOCON object or NULL if unsuccessful.
+ */
+extern GEOCON_HDR * geocon_load_async(
+   const char    *pathname,
+   GEOCON_EXTENT *extent,
+   int            load_data,
+   int           *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Check whether the data of a GEOCON object is done loading.
+ *
+ * This never waits, and is always TRUE for an object that was not
+ * loaded by geocon_load_async().
+ *
+ * @param hdr        A pointer to a GEOCON object.
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   If the load is done, this will be set to its result
+ *                   (GEOCON_ERR_OK or GEOCON_ERR_*).
+ *
+ * @return           TRUE if the load is done, FALSE if still loading.
+ */
+extern GEOCON_BOOL geocon_load_done(
+   const GEOCON_HDR *hdr,
+   int              *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Wait for the data of a GEOCON object to be done loading.
+ *
+ * This returns immediately for an object that was not
+ * loaded by geocon_load_async().
+ *
+ * <p>If the load failed, the object has no data, and can only be deleted.
+ *
+ * @param hdr        A pointer to a GEOCON object.
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if the data was loaded, -1 if error.
+ */
+extern int geocon_load_wait(
+   const GEOCON_HDR *hdr,
+   int              *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Set the size of the tile cache of a GEOCON object.
+ *
+ * <p>When the data is read on-the-fly, each shift value needed is
+ * normally read from the file when it is needed.  With a tile cache,
+ * the data is instead read in small tiles, and recently-used tiles are
+ * kept in memory (up to the given size), which is much faster when
+ * successive points are near each other.  The cache may be used by
+ * any number of threads at once.
+ *
+ * <p>If the size covers the whole grid, every tile is kept once it has
+ * been read.  If it doesn't, and tiles are not being reused (as when
+ * points are spread at random over the grid), shift values are read
+ * directly rather than in tiles.
+ *
+ * <p>This call is ignored if the data is not being read on-the-fly.
+ * It must not be made while the object is being used by another thread.
+ *
+ * @param hdr        A pointer to a GEOCON object.
+ *
+ * @param max_bytes  The max amount of memory to use for cached tiles,
+ *                   or 0 to not cache any tiles (the default).
+ *                   At least one tile is always cached.
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if OK, -1 if error.
+ */
+extern int geocon_set_cache(
+   GEOCON_HDR *hdr,
+   size_t      max_bytes,
+   int        *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Precompute the bicubic coefficients of a GEOCON object.
+ *
+ * <p>Normally, bicubic interpolation gets the 4x4 points around each
+ * point and works out the cubic polynomial through them.  This instead
+ * works out the polynomial of every cell of the grid once, so that
+ * bicubic interpolation is then just a lookup of the cell and an
+ * evaluation of its polynomial.  The results are the same, except for
+ * rounding in the last bits.
+ *
+ * <p>This trades memory for speed: the coefficients take 384 bytes for
+ * each cell (32 times as much as the data), so it is only worthwhile when
+ * very many points are transformed with bicubic interpolation.
+ *
+ * <p>The data must be in memory (loaded or mapped).  This call must not
+ * be made while the object is being used by another thread.
+ *
+ * @param hdr        A pointer to a GEOCON object.
+ *
+ * @param build      TRUE to build the coefficients, or FALSE to free them.
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if OK, -1 if error.
+ */
+extern int geocon_set_coefs(
+   GEOCON_HDR *hdr,
+   GEOCON_BOOL build,
+   int        *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Publish the data of a GEOCON object in a named shared-memory segment.
+ *
+ * <p>Any number of processes can then attach to the segment with
+ * geocon_attach(), and all share the one copy of the data, without
+ * reading the file.  The segment stays until it is removed with
+ * geocon_unpublish() (or the system is restarted).  Publishing again
+ * under the same name replaces the segment, but anyone still attached
+ * to the old one keeps using it.
+ *
+ * <p>The data must be in memory (loaded or mapped).  An extent given when
+ * loading the data applies to the segment too.
+ *
+ * <p>Shared-memory segments are not currently supported on Windows.
+ *
+ * @param hdr        A pointer to a GEOCON object.
+ *
+ * @param name       The name of the segment, as for shm_open()
+ *                   (the leading '/' is optional).
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if OK, -1 if error.
+ */
+extern int geocon_publish(
+   const GEOCON_HDR *hdr,
+   const char       *name,
+   int              *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Attach to a GEOCON object published in a shared-memory segment.
+ *
+ * <p>The segment is mapped read-only, so the object is just like one
+ * loaded with GEOCON_LOAD_MAPPED.  It is released by geocon_delete().
+ *
+ * @param name       The name of the segment.
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           A pointer to a GEOCON object or NULL if unsuccessful.
+ */
+extern GEOCON_HDR * geocon_attach(
+   const char    *name,
+   int           *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Remove a shared-memory segment published by geocon_publish().
+ *
+ * <p>Processes already attached to it are not affected.
+ *
+ * @param name       The name of the segment.
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if OK, -1 if error.
+ */
+extern int geocon_unpublish(
+   const char    *name,
    int           *prc);
 
 /*---------------------------------------------------------------------------*/
@@ -365,6 +833,8 @@ extern GEOCON_HDR * geocon_load(
  *
  * This call can also be used to write out a binary file for an object
  * that was read from an ascii file, and vice-versa.
+ * The points are always written as floats, even if they were quantized
+ * (see geocon_write_quant()).
  *
  * @param hdr        A pointer to a GEOCON_HDR object.
  *
@@ -393,11 +863,142 @@ extern int geocon_write(
    int               byte_order,
    int              *prc);
 
+/*---------------------------------------------------------------------------*/
+/**
+ * Write out a GEOCON object to a quantized binary file.
+ *
+ * <p>This is the same as writing a binary file with geocon_write(),
+ * except that the file's data format is GEOCON_DATA_QUANT (see
+ * GEOCON_QUANT).  For each component, the smallest integer size which can
+ * hold all of its values within the given max error is used, so a file
+ * may take as little as half the space (both on disk and in memory when
+ * loaded).  Every value is checked against the max error, and the max
+ * errors found are stored in the file.
+ *
+ * <p>A max error of 0 means that 4-byte integers should be used, with
+ * the smallest step that can hold all of the values of a component.
+ * This is usually more precise than the float values themselves.
+ *
+ * @param hdr        A pointer to a GEOCON_HDR object.
+ *
+ * @param pathname   The pathname of the file to write.
+ *                   This must name a binary file.
+ *
+ * @param byte_order Byte order of the output file (GEOCON_ENDIAN_*).
+ *                   (See geocon_write()).
+ *
+ * @param horz_err   The max error allowed in a lat or lon value (degrees).
+ *
+ * @param vert_err   The max error allowed in a hgt value (meters).
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if OK, -1 if error.
+ */
+extern int geocon_write_quant(
+   const GEOCON_HDR *hdr,
+   const char       *pathname,
+   int               byte_order,
+   double            horz_err,
+   double            vert_err,
+   int              *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Write out a GEOCON object to a packed (compressed) binary file.
+ *
+ * <p>This is the same as writing a binary file with geocon_write(),
+ * except that the points are compressed (losslessly), in blocks of rows
+ * (see GEOCON_BLOCK_HDR).  The points are written in the format they have
+ * in memory, so an object loaded from a quantized file is written as a
+ * packed quantized file.
+ *
+ * <p>A packed file can be loaded in all the same ways as any other
+ * binary file, except that it cannot be mapped into memory (it is just
+ * read instead).  When reading it on-the-fly, only the blocks needed are
+ * decompressed, and a few of them are kept in memory.
+ *
+ * @param hdr        A pointer to a GEOCON_HDR object.
+ *
+ * @param pathname   The pathname of the file to write.
+ *                   This must name a binary file.
+ *
+ * @param byte_order Byte order of the output file (GEOCON_ENDIAN_*).
+ *                   (See geocon_write()).
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if OK, -1 if error.
+ */
+extern int geocon_write_packed(
+   const GEOCON_HDR *hdr,
+   const char       *pathname,
+   int               byte_order,
+   int              *prc);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Write out a GEOCON object to a tiled binary file.
+ *
+ * <p>This is the same as writing a binary file with geocon_write() or
+ * geocon_write_packed(), except that the points are stored in square
+ * tiles (see GEOCON_TILE_HDR), rather than in rows.  The points are
+ * written in the format they have in memory.
+ *
+ * <p>A tiled file can be loaded in all the same ways as any other
+ * binary file, except that it cannot be mapped into memory (it is just
+ * read instead).  When reading it on-the-fly or by extent, only the tiles
+ * needed are read, and a few of them are kept in memory.  Writing the
+ * object with geocon_write() gives a classic file again.
+ *
+ * @param hdr        A pointer to a GEOCON_HDR object.
+ *
+ * @param pathname   The pathname of the file to write.
+ *                   This must name a binary file.
+ *
+ * @param byte_order Byte order of the output file (GEOCON_ENDIAN_*).
+ *                   (See geocon_write()).
+ *
+ * @param tile_size  Number of rows & columns in a tile.
+ *                   If this is 0, GEOCON_TILE_SIZE is used.
+ *
+ * @param packed     TRUE to compress each tile (see geocon_write_packed()).
+ *
+ * @param prc        A pointer to a result code.
+ *                   This pointer may be NULL.
+ *                   <ul>
+ *                     <li>If successful,   it will be set to GEOCON_ERR_OK (0).
+ *                     <li>If unsuccessful, it will be set to GEOCON_ERR_*.
+ *                   </ul>
+ *
+ * @return           0 if OK, -1 if error.
+ */
+extern int geocon_write_tiled(
+   const GEOCON_HDR *hdr,
+   const char       *pathname,
+   int               byte_order,
+   int               tile_size,
+   GEOCON_BOOL       packed,
+   int              *prc);
+
 /*---------------------------------------------------------------------------*/
 /**
  * Delete a GEOCON object
  *
  * This method will also close any open stream (and mutex) in the object.
+ * If the object is still being loaded, this will wait for that first.
+ * If the object was opened by geocon_open(), this just drops a reference
+ * to it, and it is only deleted when its last reference is dropped.
  *
  * @param hdr        A pointer to a GEOCON object.
  */
@@ -598,6 +1199,85 @@ extern int geocon_transform(
    double            h[],
    int               direction);
 
+/*---------------------------------------------------------------------------*/
+/**
+ * A task to be run by a caller-provided thread pool.
+ */
+typedef void (*GEOCON_TASK_FUNC)(void *task);
+
+/**
+ * A caller-provided thread pool.
+ *
+ * <p>This must call func(tasks[i]) once for each of the "ntasks" tasks,
+ * on any threads and in any order, and must not return until all of
+ * them are done.  "pool" is the pointer given to geocon_transform_mt().
+ */
+typedef void (*GEOCON_POOL_FUNC)(
+   void *           pool,
+   GEOCON_TASK_FUNC func,
+   void *           tasks[],
+   int              ntasks);
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Perform a forward or inverse transformation on an array of points
+ * using multiple threads.
+ *
+ * <p>This is the same as geocon_transform(), except that the array is
+ * split into parts that are transformed at the same time.  The results,
+ * including the number of points successfully transformed, are the same.
+ * Since the object is only read, this can be used with data in memory
+ * or read on-the-fly.
+ *
+ * <p>Arrays of fewer than a few thousand points are not split.
+ *
+ * @param hdr         A pointer to a GEOCON_HDR object.
+ *
+ * @param interp      The interpolation method to use
+ *                    (see geocon_transform()).
+ *
+ * @param deg_factor  The conversion factor to convert the given coordinates
+ *                    to decimal degrees.
+ *                    The value is degrees-per-unit.
+ *
+ * @param hgt_factor  The conversion factor to convert the given height
+ *                    to meters.
+ *                    The value is meters-per-unit.
+ *
+ * @param n           Number of points in the array to be transformed.
+ *
+ * @param coord       An array of GEOCON_COORD values to be transformed.
+ *
+ * @param h           An array of heights to transform. This may be NULL.
+ *
+ * @param direction   The direction of the transformation
+ *                    (GEOCON_CVT_FORWARD or GEOCON_CVT_INVERSE).
+ *
+ * @param nthreads    The max number of parts to split the array into,
+ *                    or 0 for one per CPU.  If the library runs them,
+ *                    this is also limited to GEOCON_MAX_THREADS (64).
+ *
+ * @param pool_func   A function to run the parts on the caller's own
+ *                    thread pool, or NULL to have the library start
+ *                    a thread for each part.
+ *
+ * @param pool        A pointer that is passed to pool_func.
+ *
+ * @return            The number of points successfully transformed.
+ */
+extern int geocon_transform_mt(
+   const GEOCON_HDR *hdr,
+   int               interp,
+   double            deg_factor,
+   double            hgt_factor,
+   int               n,
+   GEOCON_COORD      coord[],
+   double            h[],
+   int               direction,
+   int               nthreads,
+   GEOCON_POOL_FUNC  pool_func,
+   void *            pool);
+
 /*---------------------------------------------------------------------------*/
 
 #ifdef __cplusplus
@@ -18,18 +18,24 @@
 #  pragma warning (disable: 4996) /* _CRT_SECURE_NO_WARNINGS */
 #endif
 
+/* Use 64-bit file offsets, even in 32-bit builds. */
+#ifndef   _FILE_OFFSET_BITS
+#  define _FILE_OFFSET_BITS  64
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
 #include <ctype.h>
+#include <float.h>
 #include <locale.h>
 
+#define GEOCON_UNUSED_PARAMETER(p) (void)(p)
+
 #include "libgeocon.h"
 #include "libgeocon.i"
 
-#define GEOCON_UNUSED_PARAMETER(p) (void)(p)
-
 /* ------------------------------------------------------------------------- */
 /* floating-point comparison macros                                          */
 /* ------------------------------------------------------------------------- */
@@ -97,6 +103,9 @@ static const GEOCON_ERRS gc_errlist[] =
    { GEOCON_ERR_UNKNOWN_FILETYPE,  "Unknown filetype"    },
    { GEOCON_ERR_UNEXPECTED_EOF,    "Unexpected EOF"      },
    { GEOCON_ERR_INVALID_TOKEN_CNT, "Invalid token count" },
+   { GEOCON_ERR_NO_DATA,           "No data in memory"   },
+   { GEOCON_ERR_NOT_SUPPORTED,     "Not supported"       },
+   { GEOCON_ERR_QUANT_ERROR,       "Quantization error"  },
 
    { -1, NULL }
 };
@@ -321,11 +330,82 @@ static GEOCON_BOOL gc_is_ltl_endian(void)
      (((a) & 0x00ff0000) >>  8) | \
      (((a) & 0xff000000) >> 24) )
 
+/* Bulk byte-swapping of arrays (such as the point data) is done
+ * using whatever SIMD instructions the compiler has been told it
+ * can use, with a scalar loop for any remaining values.
+ * Defining GEOCON_NO_SIMD disables all this.
+ */
+#if   defined(GEOCON_NO_SIMD)
+#elif defined(__AVX2__)
+#  include <immintrin.h>
+#  define GEOCON_SWAP_AVX2
+#elif defined(__SSSE3__)
+#  include <tmmintrin.h>
+#  define GEOCON_SWAP_SSSE3
+#elif defined(__SSE2__) || defined(_M_X64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define GEOCON_SWAP_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define GEOCON_SWAP_NEON
+#endif
+
 static void gc_swap_int(int in[], int ntimes)
 {
-   int i;
+   int i = 0;
 
-   for (i = 0; i < ntimes; i++)
+#if defined(GEOCON_SWAP_AVX2)
+   {
+      const __m256i mask = _mm256_setr_epi8(
+          3,  2,  1,  0,   7,  6,  5,  4,
+         11, 10,  9,  8,  15, 14, 13, 12,
+          3,  2,  1,  0,   7,  6,  5,  4,
+         11, 10,  9,  8,  15, 14, 13, 12);
+
+      for (; i + 8 <= ntimes; i += 8)
+      {
+         __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+         v = _mm256_shuffle_epi8(v, mask);
+         _mm256_storeu_si256((__m256i *)(in + i), v);
+      }
+   }
+#elif defined(GEOCON_SWAP_SSSE3)
+   {
+      const __m128i mask = _mm_setr_epi8(
+          3,  2,  1,  0,   7,  6,  5,  4,
+         11, 10,  9,  8,  15, 14, 13, 12);
+
+      for (; i + 4 <= ntimes; i += 4)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+         v = _mm_shuffle_epi8(v, mask);
+         _mm_storeu_si128((__m128i *)(in + i), v);
+      }
+   }
+#elif defined(GEOCON_SWAP_SSE2)
+   {
+      /* swap the bytes in each 16-bit word, then swap the words */
+      for (; i + 4 <= ntimes; i += 4)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+         v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+         v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+         v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+         _mm_storeu_si128((__m128i *)(in + i), v);
+      }
+   }
+#elif defined(GEOCON_SWAP_NEON)
+   {
+      for (; i + 4 <= ntimes; i += 4)
+      {
+         uint8x16_t v = vld1q_u8((const uint8_t *)(in + i));
+         vst1q_u8((uint8_t *)(in + i), vrev32q_u8(v));
+      }
+   }
+#endif
+
+   for (; i < ntimes; i++)
       in[i] = SWAP4((unsigned int)in[i]);
 }
 
@@ -350,26 +430,152 @@ static void gc_swap_dbl(double in[], int ntimes)
    }
 }
 
+static void gc_swap_off(GEOCON_OFFSET in[], int ntimes)
+{
+   int i;
+
+   for (i = 0; i < ntimes; i++)
+   {
+      unsigned char * p = (unsigned char *)(&in[i]);
+      unsigned char   c;
+      int j;
+
+      for (j = 0; j < (int)sizeof(in[i]) / 2; j++)
+      {
+         c = p[j];
+         p[j] = p[sizeof(in[i]) - 1 - j];
+         p[sizeof(in[i]) - 1 - j] = c;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+ * get the decimal point character of the current locale
+ *
+ * Note that this should never be cached past a single load or write,
+ * since the locale may be changed at any time.
+ */
+static char gc_decimal_point(void)
+{
+   return localeconv()->decimal_point[0];
+}
+
 /*------------------------------------------------------------------------
  * convert a string to a double
  *
- * Note: Any '.' in the string is first converted to the localized value.
- *       This means the string cannot be const, as it may be modified.
+ * Either a '.' or the given (localized) decimal point is accepted.
+ *
+ * A number with no more than 15 significant digits and a power-of-ten
+ * exponent of no more than 22 is converted here without using the locale.
+ * Both the digits and the power of ten are then exact doubles, so a single
+ * multiply or divide gives the correctly-rounded result.  Anything else
+ * (including the rare case of extended-precision arithmetic) is passed
+ * on to atof() after any '.' is converted to the localized value.
  */
-static double gc_atod(char *s)
+#define GEOCON_ATOD_MAX_DIGITS  15
+#define GEOCON_ATOD_MAX_EXP     22
+
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD != 0)
+#  define GEOCON_ATOD_NO_FAST_PATH
+#endif
+
+static const double gc_pow10[GEOCON_ATOD_MAX_EXP + 1] =
 {
-   char   dec_pnt = localeconv()->decimal_point[0];  /* never cache this */
-   double d = 0.0;
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+   1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+   1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double gc_atod(const char *s, char dec_pnt)
+{
+   if ( s == NULL || *s == 0 )
+      return 0.0;
+
+#ifndef GEOCON_ATOD_NO_FAST_PATH
+   {
+      const unsigned char * p = (const unsigned char *)s;
+      double      mant    = 0.0;
+      int         ndigits = 0;
+      int         exp10   = 0;
+      GEOCON_BOOL neg     = FALSE;
+      GEOCON_BOOL any     = FALSE;
+
+      for (; isspace(*p); p++) ;
+
+      if ( *p == '-' || *p == '+' )
+         neg = (*p++ == '-');
+
+      /* integer part */
+      for (; isdigit(*p); p++)
+      {
+         any = TRUE;
+         if ( mant != 0.0 || *p != '0' )
+         {
+            ndigits++;
+            mant = (mant * 10.0) + (*p - '0');
+         }
+      }
 
-   if ( s != NULL && *s != 0 )
+      /* fraction part */
+      if ( *p == '.' || *p == (unsigned char)dec_pnt )
+      {
+         for (p++; isdigit(*p); p++)
+         {
+            any = TRUE;
+            if ( mant != 0.0 || *p != '0' )
+            {
+               ndigits++;
+               mant = (mant * 10.0) + (*p - '0');
+            }
+            exp10--;
+         }
+      }
+
+      /* exponent part */
+      if ( any && (*p == 'e' || *p == 'E') )
+      {
+         const unsigned char * e = p + 1;
+         GEOCON_BOOL eneg = FALSE;
+         int         eval = 0;
+
+         if ( *e == '-' || *e == '+' )
+            eneg = (*e++ == '-');
+
+         if ( isdigit(*e) )
+         {
+            for (; isdigit(*e); e++)
+            {
+               if ( eval < 10000 )
+                  eval = (eval * 10) + (*e - '0');
+            }
+            exp10 += (eneg ? -eval : eval);
+            p = e;
+         }
+      }
+
+      if ( any && !isalnum(*p) && ndigits <= GEOCON_ATOD_MAX_DIGITS )
+      {
+         if ( exp10 >= 0 && exp10 <= GEOCON_ATOD_MAX_EXP )
+            return neg ? -(mant * gc_pow10[ exp10]) : (mant * gc_pow10[ exp10]);
+
+         if ( exp10 <  0 && exp10 >= -GEOCON_ATOD_MAX_EXP )
+            return neg ? -(mant / gc_pow10[-exp10]) : (mant / gc_pow10[-exp10]);
+      }
+   }
+#endif
+
+   /* do it the slow way */
    {
-      char *p = strchr(s, '.');
+      char  buf[GEOCON_TOKENS_BUFLEN];
+      char *p;
+
+      gc_strncpy(buf, s, sizeof(buf));
+      p = strchr(buf, '.');
       if ( p != NULL )
          *p = dec_pnt;
-      d = atof(s);
-   }
 
-   return d;
+      return atof(buf);
+   }
 }
 
 /*------------------------------------------------------------------------
@@ -382,7 +588,7 @@ static double gc_atod(char *s)
  */
 static char * gc_dtoa(char *buf, double dbl)
 {
-   char dec_pnt = localeconv()->decimal_point[0];  /* never cache this */
+   char dec_pnt = gc_decimal_point();
    char *s;
 
    sprintf(buf, "%.9f", dbl);
@@ -414,6 +620,90 @@ static char * gc_dtoa(char *buf, double dbl)
    return buf;
 }
 
+/*------------------------------------------------------------------------
+ * format a float value as "%16.9f" would (with a '.' decimal point)
+ *
+ * A float is an integer times a power of 2, so (value * 10^9) can be
+ * worked out exactly in 64-bit integers and rounded to nearest, ties to
+ * even, which is what printf does.  This is only done for values less
+ * than 2^32, which covers any shift value, and gc_dtoa() is used for any
+ * others.
+ *
+ * Returns the length of the string.
+ */
+static int gc_ftoa(char *buf, float flt)
+{
+   unsigned int  bits;
+   GEOCON_OFFSET n;
+   char          tmp[64];
+   char *        p = tmp + sizeof(tmp);
+   int           e;
+   int           len;
+   int           i;
+
+   memcpy(&bits, &flt, sizeof(bits));
+   e = (int)((bits >> 23) & 0xff);
+   n = (GEOCON_OFFSET)(bits & 0x7fffff);
+
+   if ( e > 127 + 31 )
+   {
+      /* too big (or inf or nan) */
+      return sprintf(buf, "%16s", gc_dtoa(tmp, flt));
+   }
+
+   /* value = n * 2^e */
+
+   if ( e == 0 )
+      e = 1;
+   else
+      n |= 0x800000;
+   e -= 150;
+
+   n *= 1000000000;
+   if ( e >= 0 )
+   {
+      n <<= e;
+   }
+   else
+   if ( e < -62 )
+   {
+      n = 0;
+   }
+   else
+   {
+      GEOCON_OFFSET half = (GEOCON_OFFSET)1 << (-e - 1);
+      GEOCON_OFFSET rem  = n & ((half << 1) - 1);
+
+      n >>= -e;
+      if ( rem > half || (rem == half && (n & 1) != 0) )
+         n++;
+   }
+
+   /* output the digits backwards */
+
+   for (i = 0; i < 9; i++)
+   {
+      *--p = (char)('0' + (int)(n % 10));
+      n /= 10;
+   }
+   *--p = '.';
+   do
+   {
+      *--p = (char)('0' + (int)(n % 10));
+      n /= 10;
+   } while ( n > 0 );
+
+   if ( (bits & 0x80000000) != 0 )
+      *--p = '-';
+
+   len = (int)((tmp + sizeof(tmp)) - p);
+   for (i = len; i < 16; i++)
+      *buf++ = ' ';
+   memcpy(buf, p, len);
+
+   return GEOCON_MAX(len, 16);
+}
+
 /* -------------------------------------------------------------------------- */
 /* internal misc GEOCON routines                                              */
 /* -------------------------------------------------------------------------- */
@@ -427,7 +717,7 @@ static void gc_flip_hdr(
    gc_swap_int( &fhdr->magic,           1 );
    gc_swap_int( &fhdr->version,         1 );
    gc_swap_int( &fhdr->hdrlen,          1 );
-   gc_swap_int( &fhdr->reserved,        1 );
+   gc_swap_int( &fhdr->data_fmt,        1 );
 
    gc_swap_int( &fhdr->lat_dir,         1 );
    gc_swap_int( &fhdr->lon_dir,         1 );
@@ -455,14 +745,55 @@ static void gc_flip_hdr(
 }
 
 /*------------------------------------------------------------------------
- * byte-swap a point
+ * byte-swap an array of points
+ */
+static void gc_flip_points(
+   GEOCON_POINT * pts,
+   int            npts)
+{
+   gc_swap_flt( &pts->lat_value, npts * 3 );
+}
+
+/*------------------------------------------------------------------------
+ * reverse the order of the points in a row (E-W <-> W-E)
+ */
+static void gc_reverse_row(
+   GEOCON_POINT * row,
+   int            ncols)
+{
+   GEOCON_POINT * lft = row;
+   GEOCON_POINT * rgt = row + (ncols - 1);
+
+   for (; lft < rgt; lft++, rgt--)
+   {
+      GEOCON_POINT tmp = *lft;
+      *lft = *rgt;
+      *rgt = tmp;
+   }
+}
+
+/*------------------------------------------------------------------------
+ * reverse the order of a block of rows (N-S <-> S-N)
  */
-static void gc_flip_point(
-   GEOCON_POINT * pt)
+static void gc_reverse_rows(
+   GEOCON_POINT * rows,
+   int            nrows,
+   int            ncols)
 {
-   gc_swap_flt( &pt->lat_value, 1 );
-   gc_swap_flt( &pt->lon_value, 1 );
-   gc_swap_flt( &pt->hgt_value, 1 );
+   GEOCON_POINT * bot = rows;
+   GEOCON_POINT * top = rows + ((size_t)(nrows - 1) * ncols);
+
+   for (; bot < top; bot += ncols, top -= ncols)
+   {
+      int c;
+
+      for (c = 0; c < ncols; c++)
+      {
+         GEOCON_POINT tmp = bot[c];
+         bot[c] = top[c];
+         top[c] = tmp;
+      }
+   }
 }
 
 /*------------------------------------------------------------------------
@@ -504,314 +835,347 @@ static double gc_delta(double d)
 }
 
 /* -------------------------------------------------------------------------- */
-/* internal read routines                                                     */
+/* internal quantization routines                                             */
 /* -------------------------------------------------------------------------- */
 
+/* Largest number of steps from the base that we allow in a quantized
+   component of each size.  These leave room for rounding.
+*/
+#define GEOCON_QUANT_MAX_2     32766.0
+#define GEOCON_QUANT_MAX_4     2147483646.0
+
 /*------------------------------------------------------------------------
- * Read in a line from an ascii stream.
- *
- * This will read in a line, strip all leading and trailing whitespace,
- * and discard any blank lines and comments (anything following a #).
- *
- * Returns NULL at EOF.
+ * byte-swap quantization info
  */
-static char * gc_read_line(GEOCON_HDR *hdr, char *buf, size_t buflen)
+static void gc_flip_quant(
+   GEOCON_QUANT *quant)
 {
-   char * bufp;
+   gc_swap_int(  quant->size,           3 );
+   gc_swap_int( &quant->reserved,       1 );
 
-   for (;;)
-   {
-      char *p;
+   gc_swap_dbl(  quant->base,           3 );
+   gc_swap_dbl(  quant->step,           3 );
+   gc_swap_dbl(  quant->max_err,        3 );
+}
 
-      bufp = fgets(buf, (int)buflen, hdr->fp);
-      if ( bufp == NULL )
-         break;
-      hdr->line_count++;
+/*------------------------------------------------------------------------
+ * check quantization info read from a file
+ */
+static GEOCON_BOOL gc_quant_is_valid(
+   const GEOCON_QUANT *quant)
+{
+   int k;
 
-      p = strchr(bufp, '#');
-      if ( p != NULL )
-         *p = 0;
+   for (k = 0; k < 3; k++)
+   {
+      if ( quant->size[k] != 2 && quant->size[k] != 4 )
+         return FALSE;
+   }
 
-      bufp = gc_strip(bufp);
-      if ( *bufp != 0 )
-         break;
+   return TRUE;
+}
+
+/*------------------------------------------------------------------------
+ * get the length of a point (both in the file and in memory)
+ */
+static size_t gc_point_len(
+   const GEOCON_HDR *hdr)
+{
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+   {
+      return (size_t)(hdr->quant.size[GEOCON_QUANT_LAT] +
+                      hdr->quant.size[GEOCON_QUANT_LON] +
+                      hdr->quant.size[GEOCON_QUANT_HGT]);
    }
 
-   return bufp;
+   return sizeof(GEOCON_POINT);
 }
 
 /*------------------------------------------------------------------------
- * read in a tokenized line
- *
- * Returns number of tokens or -1 at EOF
+ * byte-swap an array of quantized points
  */
-static int gc_read_toks(GEOCON_HDR *hdr, GEOCON_TOKEN *ptok, int maxtoks)
+static void gc_flip_qpoints(
+   const GEOCON_QUANT * quant,
+   void *               qpts,
+   size_t               npts)
 {
-   char  buf[GEOCON_TOKENS_BUFLEN];
-   char *bufp;
+   unsigned char * p = (unsigned char *)qpts;
+   size_t i;
 
-   bufp = gc_read_line(hdr, buf, sizeof(buf));
-   if ( bufp == NULL )
-      return -1;
+   for (i = 0; i < npts; i++)
+   {
+      int k;
 
-   return gc_str_tokenize(ptok, bufp, NULL, maxtoks);
-}
+      for (k = 0; k < 3; k++)
+      {
+         unsigned char * lo = p;
+         unsigned char * hi = p + (quant->size[k] - 1);
 
-#define RT(n)    if ( gc_read_toks(hdr, &tok, n) <= 0 )  \
-                 {                                       \
-                    *prc = GEOCON_ERR_UNEXPECTED_EOF;    \
-                    return -1;                           \
-                 }                                       \
-                 if ( tok.num != n )                     \
-                 {                                       \
-                    *prc = GEOCON_ERR_INVALID_TOKEN_CNT; \
-                    return -1;                           \
-                 }
+         for (; lo < hi; lo++, hi--)
+         {
+            unsigned char tmp = *lo;
+            *lo = *hi;
+            *hi = tmp;
+         }
 
-#define TOK(i)   tok.toks[i]
+         p += quant->size[k];
+      }
+   }
+}
 
 /*------------------------------------------------------------------------
- * load a binary header
+ * reverse the order of the quantized points in a row (E-W <-> W-E)
  */
-static int gc_load_hdr_bin(
-   GEOCON_HDR *hdr,
-   int        *prc)
+static void gc_reverse_qrow(
+   void *         row,
+   int            ncols,
+   size_t         len)
 {
-   GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
-   size_t nr;
+   unsigned char * lft = (unsigned char *)row;
+   unsigned char * rgt = lft + ((ncols - 1) * len);
+   unsigned char   tmp[sizeof(GEOCON_POINT)];
 
-   nr = fread(fhdr, sizeof(*fhdr), 1, hdr->fp);
-   if ( nr != 1 )
+   for (; lft < rgt; lft += len, rgt -= len)
    {
-      *prc = GEOCON_ERR_IOERR;
-      return -1;
+      memcpy(tmp, lft, len);
+      memcpy(lft, rgt, len);
+      memcpy(rgt, tmp, len);
    }
-   hdr->points_start = ftell(hdr->fp);
+}
 
-   if ( fhdr->magic == GEOCON_HDR_MAGIC_SWAPPED )
-   {
-      gc_flip_hdr(fhdr);
-      hdr->flip = TRUE;
-   }
+/*------------------------------------------------------------------------
+ * reverse the order of a block of quantized rows (N-S <-> S-N)
+ */
+static void gc_reverse_qrows(
+   void *         rows,
+   int            nrows,
+   int            ncols,
+   size_t         len)
+{
+   size_t          row_len = ncols * len;
+   unsigned char * bot     = (unsigned char *)rows;
+   unsigned char * top     = bot + ((size_t)(nrows - 1) * row_len);
 
-   if ( fhdr->magic != GEOCON_HDR_MAGIC )
+   for (; bot < top; bot += row_len, top -= row_len)
    {
-      *prc = GEOCON_ERR_INVALID_FILE;
-      return -1;
-   }
+      size_t i;
 
-   return 0;
+      for (i = 0; i < row_len; i++)
+      {
+         unsigned char tmp = bot[i];
+         bot[i] = top[i];
+         top[i] = tmp;
+      }
+   }
 }
 
 /*------------------------------------------------------------------------
- * load an ascii header
+ * decode a quantized point
  */
-static int gc_load_hdr_asc(
-   GEOCON_HDR *hdr,
-   int        *prc)
+static void gc_decode_point(
+   const GEOCON_QUANT * quant,
+   const void *         qpt,
+   GEOCON_POINT *       pt)
 {
-   GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
-   GEOCON_TOKEN tok;
+   const unsigned char * p = (const unsigned char *)qpt;
+   float * v = &pt->lat_value;
+   int k;
 
-   RT(2); gc_strncpy( fhdr->info,           TOK(1), sizeof(fhdr->info)   );
-   RT(2); gc_strncpy( fhdr->source,         TOK(1), sizeof(fhdr->source) );
-   RT(2); gc_strncpy( fhdr->date,           TOK(1), sizeof(fhdr->date)   );
+   for (k = 0; k < 3; k++)
+   {
+      double q;
 
-   RT(2); fhdr->lat_dir      = (gc_strcmp_i(TOK(1), "N-S") == 0) ?
-                                                    GEOCON_LAT_N_TO_S :
-                                                    GEOCON_LAT_S_TO_N ;
+      if ( quant->size[k] == 2 )
+      {
+         short s;
+         memcpy(&s, p, sizeof(s));
+         q = s;
+      }
+      else
+      {
+         int i;
+         memcpy(&i, p, sizeof(i));
+         q = i;
+      }
 
-   RT(2); fhdr->lon_dir      = (gc_strcmp_i(TOK(1), "E-W") == 0) ?
-                                                    GEOCON_LON_E_TO_W :
-                                                    GEOCON_LON_W_TO_E ;
-
-   RT(2); fhdr->nrows            = atoi(    TOK(1) );
-   RT(2); fhdr->ncols            = atoi(    TOK(1) );
-
-   RT(2); fhdr->lat_south        = gc_atod( TOK(1) );
-   RT(2); fhdr->lat_north        = gc_atod( TOK(1) );
-
-   RT(2); fhdr->lon_west         = gc_atod( TOK(1) );
-   RT(2); fhdr->lon_east         = gc_atod( TOK(1) );
-
-   RT(2); fhdr->lat_delta        = gc_atod( TOK(1) );
-   RT(2); fhdr->lon_delta        = gc_atod( TOK(1) );
-
-   RT(2); fhdr->horz_scale       = gc_atod( TOK(1) );
-   RT(2); fhdr->vert_scale       = gc_atod( TOK(1) );
-
-   RT(2); gc_strncpy( fhdr->from_gcs,       TOK(1), sizeof(fhdr->from_gcs) );
-   RT(2); gc_strncpy( fhdr->from_vcs,       TOK(1), sizeof(fhdr->from_vcs) );
-   RT(2); fhdr->from_semi_major  = gc_atod( TOK(1) );
-   RT(2); fhdr->from_flattening  = gc_atod( TOK(1) );
-
-   RT(2); gc_strncpy( fhdr->to_gcs,         TOK(1), sizeof(fhdr->to_gcs)   );
-   RT(2); gc_strncpy( fhdr->to_vcs,         TOK(1), sizeof(fhdr->to_vcs)   );
-   RT(2); fhdr->to_semi_major    = gc_atod( TOK(1) );
-   RT(2); fhdr->to_flattening    = gc_atod( TOK(1) );
-
-   return 0;
+      v[k] = (float)(quant->base[k] + (q * quant->step[k]));
+      p   += quant->size[k];
+   }
 }
 
 /*------------------------------------------------------------------------
- * load a header
+ * decode an array of quantized points in place
+ *
+ * The quantized points are at the start of the array, and, since they
+ * are never longer than the points, they are decoded from the end back.
  */
-static int gc_load_hdr(
-   GEOCON_HDR *hdr,
-   int        *prc)
+static void gc_decode_points(
+   const GEOCON_HDR * hdr,
+   GEOCON_POINT       pts[],
+   int                n)
 {
-   int rc;
-
-   if ( hdr->filetype == GEOCON_FILE_TYPE_BIN )
-      rc =  gc_load_hdr_bin(hdr, prc);
-   else
-      rc =  gc_load_hdr_asc(hdr, prc);
+   size_t len = gc_point_len(hdr);
+   int    i;
 
-   if ( rc == 0 )
+   for (i = n - 1; i >= 0; i--)
    {
-      hdr->lat_dir       = hdr->fhdr.lat_dir;
-      hdr->lon_dir       = hdr->fhdr.lon_dir;
-
-      hdr->nrows         = hdr->fhdr.nrows;
-      hdr->ncols         = hdr->fhdr.ncols;
-
-      hdr->lat_min       = hdr->fhdr.lat_south;
-      hdr->lat_max       = hdr->fhdr.lat_north;
-      hdr->lon_min       = hdr->fhdr.lon_west;
-      hdr->lon_max       = hdr->fhdr.lon_east;
-
-      hdr->lat_delta     = hdr->fhdr.lat_delta;
-      hdr->lon_delta     = hdr->fhdr.lon_delta;
-      hdr->horz_scale    = hdr->fhdr.horz_scale;
-      hdr->vert_scale    = hdr->fhdr.vert_scale;
+      unsigned char qpt[sizeof(GEOCON_POINT)];
 
-      hdr->lat_min_ghost = (hdr->lat_min - hdr->lat_delta);
-      hdr->lat_max_ghost = (hdr->lat_max + hdr->lat_delta);
-      hdr->lon_min_ghost = (hdr->lon_min - hdr->lon_delta);
-      hdr->lon_max_ghost = (hdr->lon_max + hdr->lon_delta);
+      memcpy(qpt, (unsigned char *)pts + (i * len), len);
+      gc_decode_point(&hdr->quant, qpt, &pts[i]);
    }
-
-   return rc;
 }
 
 /*------------------------------------------------------------------------
- * adjust a header against an extent
+ * quantize a point
  */
-static int gc_adjust_extent(
-   GEOCON_HDR    *hdr,
-   GEOCON_EXTENT *ext,
-   int           *skip_south,
-   int           *skip_north,
-   int           *skip_west,
-   int           *skip_east,
-   GEOCON_BOOL    adjust_hdr,
-   int           *prc)
+static void gc_encode_point(
+   const GEOCON_QUANT * quant,
+   const GEOCON_POINT * pt,
+   void *               qpt)
 {
-   double lat_min;
-   double lat_max;
-   double lon_min;
-   double lon_max;
-   double d;
+   unsigned char * p = (unsigned char *)qpt;
+   const float *   v = &pt->lat_value;
    int k;
 
-   *skip_south  = 0;
-   *skip_north  = 0;
-   *skip_west   = 0;
-   *skip_east   = 0;
+   for (k = 0; k < 3; k++)
+   {
+      double q = floor(((v[k] - quant->base[k]) / quant->step[k]) + 0.5);
 
-   if ( ext == GEOCON_NULL )
-      return 0;
+      if ( quant->size[k] == 2 )
+      {
+         short s;
+         q = GEOCON_MAX(q, -GEOCON_QUANT_MAX_2 - 1);
+         q = GEOCON_MIN(q,  GEOCON_QUANT_MAX_2 + 1);
+         s = (short)q;
+         memcpy(p, &s, sizeof(s));
+      }
+      else
+      {
+         int i;
+         q = GEOCON_MAX(q, -GEOCON_QUANT_MAX_4 - 1);
+         q = GEOCON_MIN(q,  GEOCON_QUANT_MAX_4 + 1);
+         i = (int)q;
+         memcpy(p, &i, sizeof(i));
+      }
 
-   lat_min = ext->slat;
-   lat_max = ext->nlat;
-   lon_min = ext->wlon;
-   lon_max = ext->elon;
+      p += quant->size[k];
+   }
+}
 
-   if ( GEOCON_GE( lat_min, lat_max ) ||
-        GEOCON_GE( lon_min, lon_max ) )
+/*------------------------------------------------------------------------
+ * check if an object's data is in memory (quantized, planar, or not)
+ */
+static GEOCON_BOOL gc_data_in_memory(
+   const GEOCON_HDR *hdr)
+{
+   return ( hdr->points != GEOCON_NULL || hdr->qpoints != GEOCON_NULL ||
+            hdr->planes != GEOCON_NULL );
+}
+
+/*------------------------------------------------------------------------
+ * get a point from memory
+ *
+ * "offset" is the index of the point in the points array.
+ */
+static void gc_get_point(
+   const GEOCON_HDR * hdr,
+   size_t             offset,
+   GEOCON_POINT *     pt)
+{
+   if ( hdr->qpoints != GEOCON_NULL )
    {
-      if ( prc != GEOCON_NULL )
-         *prc = GEOCON_ERR_INVALID_EXTENT;
-      return -1;
+      gc_decode_point(&hdr->quant,
+         (const unsigned char *)hdr->qpoints + (offset * gc_point_len(hdr)),
+         pt);
    }
+   else
+   if ( hdr->planes != GEOCON_NULL )
+   {
+      size_t npts = (size_t)hdr->nrows * hdr->ncols;
 
-   if ( GEOCON_GE( lat_min, hdr->lat_max ) ||
-        GEOCON_LE( lat_max, hdr->lat_min ) ||
-        GEOCON_GE( lon_min, hdr->lon_max ) ||
-        GEOCON_LE( lon_max, hdr->lon_min ) )
+      pt->lat_value = hdr->planes[offset];
+      pt->lon_value = hdr->planes[offset + npts];
+      pt->hgt_value = hdr->planes[offset + npts + npts];
+   }
+   else
    {
-      if ( prc != GEOCON_NULL )
-         *prc = GEOCON_ERR_INVALID_EXTENT;
-      return -1;
+      *pt = hdr->points[offset];
    }
+}
 
-   lat_min = GEOCON_MAX( lat_min, hdr->lat_min );
-   lat_max = GEOCON_MIN( lat_max, hdr->lat_max );
-   lon_min = GEOCON_MAX( lon_min, hdr->lon_min );
-   lon_max = GEOCON_MIN( lon_max, hdr->lon_max );
-
-   /* adjust edges of extent to match multiples of the delta */
+/*------------------------------------------------------------------------
+ * get the range of each component of an object's data
+ */
+static void gc_quant_range(
+   const GEOCON_HDR *hdr,
+   double            vmin[3],
+   double            vmax[3])
+{
+   size_t npts = (size_t)hdr->nrows * hdr->ncols;
+   size_t i;
+   int    k;
 
-   if ( GEOCON_GT(lat_min, hdr->lat_min) )
+   for (k = 0; k < 3; k++)
    {
-      d = (lat_min - hdr->lat_min) / hdr->lat_delta;
-      k = (int)floor(d);
-
-      if ( k > 0 )
-      {
-         *skip_south = k;
-         if ( adjust_hdr )
-         {
-            hdr->lat_min += (k * hdr->lat_delta);
-            hdr->nrows   -= k;
-         }
-      }
+      vmin[k] = 0.0;
+      vmax[k] = 0.0;
    }
 
-   if ( GEOCON_LT(lat_max, hdr->lat_max) )
+   for (i = 0; i < npts; i++)
    {
-      d = (hdr->lat_max - lat_max) / hdr->lat_delta;
-      k = (int)floor(d);
+      GEOCON_POINT pt;
+      const float * v = &pt.lat_value;
 
-      if ( k > 0 )
+      gc_get_point(hdr, i, &pt);
+      for (k = 0; k < 3; k++)
       {
-         *skip_north = k;
-         if ( adjust_hdr )
-         {
-            hdr->lat_max -= (k * hdr->lat_delta);
-            hdr->nrows   -= k;
-         }
+         if ( i == 0 || v[k] < vmin[k] )  vmin[k] = v[k];
+         if ( i == 0 || v[k] > vmax[k] )  vmax[k] = v[k];
       }
    }
+}
 
-   if ( GEOCON_GT(lon_min, hdr->lon_min) )
+/*------------------------------------------------------------------------
+ * check the quantization of all of an object's data
+ *
+ * This gets the actual max errors, and fails if any is more than the max
+ * error allowed (if that is not 0).
+ */
+static int gc_quant_check(
+   const GEOCON_HDR *hdr,
+   GEOCON_QUANT     *quant,
+   const double      max_err[3],
+   int              *prc)
+{
+   size_t npts = (size_t)hdr->nrows * hdr->ncols;
+   size_t i;
+   int    k;
+
+   for (i = 0; i < npts; i++)
    {
-      d = (lon_min - hdr->lon_min) / hdr->lon_delta;
-      k = (int)floor(d);
+      GEOCON_POINT pt;
+      GEOCON_POINT qt;
+      unsigned char qpt[sizeof(GEOCON_POINT)];
+      const float * v = &pt.lat_value;
+      const float * w = &qt.lat_value;
 
-      if ( k > 0 )
+      gc_get_point(hdr, i, &pt);
+      gc_encode_point(quant, &pt, qpt);
+      gc_decode_point(quant, qpt, &qt);
+
+      for (k = 0; k < 3; k++)
       {
-         *skip_west = k;
-         if ( adjust_hdr )
-         {
-            hdr->lon_min += (k * hdr->lon_delta);
-            hdr->ncols   -= k;
-         }
-      }
-   }
+         double err = GEOCON_ABS((double)w[k] - (double)v[k]);
 
-   if ( GEOCON_LT(lon_max, hdr->lon_max) )
-   {
-      d = (hdr->lon_max - lon_max) / hdr->lon_delta;
-      k = (int)floor(d);
+         if ( err > quant->max_err[k] )
+            quant->max_err[k] = err;
 
-      if ( k > 0 )
-      {
-         *skip_east = k;
-         if ( adjust_hdr )
+         if ( max_err[k] > 0.0 &&
+              err > max_err[k] + (GEOCON_ABS(v[k]) * FLT_EPSILON) )
          {
-            hdr->lon_max -= (k * hdr->lon_delta);
-            hdr->ncols   -= k;
+            *prc = GEOCON_ERR_QUANT_ERROR;
+            return -1;
          }
       }
    }
@@ -820,1348 +1184,5748 @@ static int gc_adjust_extent(
 }
 
 /*------------------------------------------------------------------------
- * load binary data, processing it against an extent
+ * choose how to quantize an object's data
+ *
+ * For each component, the max error allowed gives the step, and the
+ * range of its values then gives the size.  All values are then checked,
+ * which also gives the actual max errors.  Note that decoding a value to
+ * a float may add up to half a unit in the last place of the float.
  */
-static int gc_load_data_ext(
-   GEOCON_HDR    *hdr,
-   GEOCON_EXTENT *ext,
-   int           *prc)
+static int gc_quant_choose(
+   const GEOCON_HDR *hdr,
+   double            horz_err,
+   double            vert_err,
+   GEOCON_QUANT     *quant,
+   int              *prc)
 {
-   GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
-   size_t nr;
-   long offset;
-   int  skip_south = 0;
-   int  skip_north = 0;
-   int  skip_west  = 0;
-   int  skip_east  = 0;
-   int  r;
-   int  c;
-   int  rc = 0;
-
-   /* Calculate the amount of data to cut out
-      and update header (not file header) values.
-   */
-   rc = gc_adjust_extent(hdr, ext,
-      &skip_south, &skip_north, &skip_west, &skip_east, TRUE, prc);
-   if ( rc != 0 )
-      return rc;
-
-   /* allocate the points array */
+   double max_err[3];
+   double vmin[3];
+   double vmax[3];
+   int    k;
 
-   hdr->points = (GEOCON_POINT *)
-                 gc_memalloc(hdr->nrows * hdr->ncols * sizeof(*hdr->points));
-   if ( hdr->points == GEOCON_NULL )
-   {
-      *prc = GEOCON_ERR_NO_MEMORY;
-      return -1;
-   }
+   max_err[GEOCON_QUANT_LAT] = horz_err * hdr->horz_scale;
+   max_err[GEOCON_QUANT_LON] = horz_err * hdr->horz_scale;
+   max_err[GEOCON_QUANT_HGT] = vert_err * hdr->vert_scale;
 
-   /* skip over any rows at the start that are to be cut out. */
+   gc_quant_range(hdr, vmin, vmax);
 
-   if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
-      offset = skip_south;
-   else
-      offset = skip_north;
+   /* pick the size and step of each component */
 
-   if ( offset > 0 )
-   {
-      offset *= (fhdr->ncols * sizeof(GEOCON_POINT));
-      fseek(hdr->fp, offset, SEEK_CUR);
-   }
+   memset(quant, 0, sizeof(*quant));
 
-   /* Now read in rows of data.  Note that we may not read all
-      the way to the end of the file.
-   */
-   for (r = 0; r < hdr->nrows; r++)
+   for (k = 0; k < 3; k++)
    {
-      GEOCON_POINT * p;
+      double half = (vmax[k] - vmin[k]) / 2;
+      double step = 2 * max_err[k];
 
-      /* skip over leading values in row to be cut out */
+      quant->base[k] = vmin[k] + half;
 
-      if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-         offset = skip_west;
-      else
-         offset = skip_east;
-
-      if ( offset > 0 )
+      if ( half == 0.0 )
       {
-         fseek(hdr->fp, offset * sizeof(*p), SEEK_CUR);
+         quant->size[k] = 2;
+         quant->step[k] = 1.0;
       }
-
-      /* read in data values we want */
-
-      for (c = 0; c < hdr->ncols; c++)
+      else
+      if ( step > 0.0 && (half / step) <= GEOCON_QUANT_MAX_2 )
       {
-         /* locate where the next point is to be read into */
-
-         if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
-            offset  = (r * hdr->ncols);
-         else
-            offset  = (((hdr->nrows-1) - r) * hdr->ncols);
-
-         if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-            offset += c;
-         else
-            offset += ((hdr->ncols-1) - c);
-
-         p = hdr->points + offset;
-
-         nr = fread(p, sizeof(*p), 1, hdr->fp);
-         if ( nr != 1 )
-         {
-            *prc = GEOCON_ERR_IOERR;
-            rc = -1;
-            break;
-         }
-
-         if ( hdr->flip )
-         {
-            gc_flip_point(p);
-         }
+         quant->size[k] = 2;
+         quant->step[k] = step;
       }
-
-      /* skip over trailing values in row to be cut out */
-
-      if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-         offset = skip_east;
       else
-         offset = skip_west;
-
-      if ( offset > 0 )
       {
-         fseek(hdr->fp, offset * sizeof(*p), SEEK_CUR);
+         quant->size[k] = 4;
+         quant->step[k] = half / GEOCON_QUANT_MAX_4;
+         if ( step > quant->step[k] )
+            quant->step[k] = step;
       }
    }
 
-   return rc;
+   /* now check all values */
+
+   return gc_quant_check(hdr, quant, max_err, prc);
 }
 
+/* -------------------------------------------------------------------------- */
+/* internal block compression routines                                        */
+/* -------------------------------------------------------------------------- */
+
 /*------------------------------------------------------------------------
- * load binary data
+ * block compression
+ *
+ * In a packed file, the points are stored in blocks of rows (or in tiles,
+ * if the file is also tiled), each of which is compressed on its own, so
+ * that any point can be read without reading anything but its block.
+ * A block (of points in file order and byte-order) is compressed by:
+ *
+ *   1. Shuffling its bytes, so that byte k of every point comes together.
+ *      Since the data is smooth, the high-order bytes then form long runs
+ *      of equal or nearly-equal values.
+ *   2. Replacing each byte by its difference from the byte before it.
+ *   3. Compressing the result with a simple LZ77 scheme.
+ *
+ * The LZ77 data is a series of sequences, each of which consists of:
+ *
+ *   - a token byte, whose high 4 bits are the literal count and whose
+ *     low 4 bits are the match length minus GEOCON_LZ_MIN_MATCH
+ *   - if the literal count is 15, more bytes which are added to it,
+ *     up to and including the first one that is not 255
+ *   - the literal bytes
+ *   - a 2-byte (little-endian) offset back to the match (1 to 65535)
+ *   - if the match length is 15, more bytes which are added to it,
+ *     as for the literal count
+ *
+ * except that the last sequence ends after its literals, at the end of
+ * the block.
  */
-static int gc_load_data_bin(
-   GEOCON_HDR    *hdr,
-   GEOCON_EXTENT *ext,
-   int           *prc)
-{
-   size_t nr;
-   int r;
-   int c;
-   int rc = 0;
+#ifndef   GEOCON_PACK_BLOCK_SIZE
+#  define GEOCON_PACK_BLOCK_SIZE  (64 * 1024)  /* max bytes in a block */
+#endif
 
-   if ( !gc_extent_is_empty(ext) )
-   {
-      return gc_load_data_ext(hdr, ext, prc);
-   }
+#ifndef   GEOCON_PACK_CACHE
+#  define GEOCON_PACK_CACHE   8    /* blocks kept for reading on-the-fly */
+#endif
 
-   /* allocate memory for the point array */
+#define GEOCON_LZ_MIN_MATCH   4
+#define GEOCON_LZ_MAX_OFFSET  65535
+#define GEOCON_LZ_HASH_BITS   14
+#define GEOCON_LZ_HASH(p)     \
+   ( (((unsigned int)(p)[0]        |   \
+      ((unsigned int)(p)[1] <<  8) |   \
+      ((unsigned int)(p)[2] << 16) |   \
+      ((unsigned int)(p)[3] << 24)) * 2654435761U) >> \
+     (32 - GEOCON_LZ_HASH_BITS) )
 
-   hdr->points = (GEOCON_POINT *)
-                 gc_memalloc(hdr->nrows * hdr->ncols * sizeof(*hdr->points));
-   if ( hdr->points == GEOCON_NULL )
-   {
-      *prc = GEOCON_ERR_NO_MEMORY;
-      return -1;
-   }
+/*------------------------------------------------------------------------
+ * get the max length of a compressed block
+ */
+static size_t gc_lz_bound(
+   size_t len)
+{
+   return len + (len / 255) + 16;
+}
+
+/*------------------------------------------------------------------------
+ * write a length that doesn't fit in a token
+ */
+static unsigned char * gc_lz_put_len(
+   unsigned char *op,
+   size_t         len)
+{
+   for (; len >= 255; len -= 255)
+      *op++ = 255;
+   *op++ = (unsigned char)len;
 
-   /* read in all points */
+   return op;
+}
 
-   for (r = 0; r < hdr->nrows; r++)
+/*------------------------------------------------------------------------
+ * compress a buffer
+ *
+ * The output buffer must be at least gc_lz_bound(len) bytes.
+ * Returns the length of the compressed data.
+ */
+static size_t gc_lz_compress(
+   const unsigned char *in,
+   size_t               len,
+   unsigned char       *out)
+{
+   static const unsigned int none = 0xffffffff;
+   unsigned int    table[1 << GEOCON_LZ_HASH_BITS];
+   const unsigned char * ip     = in;
+   const unsigned char * anchor = in;
+   const unsigned char * end    = in + len;
+   unsigned char * op = out;
+   size_t i;
+
+   for (i = 0; i < (1 << GEOCON_LZ_HASH_BITS); i++)
+      table[i] = none;
+
+   while ( ip + GEOCON_LZ_MIN_MATCH <= end )
    {
-      for (c = 0; c < hdr->ncols; c++)
+      unsigned int h   = GEOCON_LZ_HASH(ip);
+      size_t       ref = table[h];
+      size_t       lits;
+      size_t       mlen;
+      unsigned char * token;
+
+      table[h] = (unsigned int)(ip - in);
+
+      if ( ref == none                                       ||
+           (size_t)(ip - in) - ref > GEOCON_LZ_MAX_OFFSET    ||
+           memcmp(in + ref, ip, GEOCON_LZ_MIN_MATCH) != 0 )
       {
-         GEOCON_POINT * p = GEOCON_NULL;
-         int offset;
+         ip++;
+         continue;
+      }
 
-         /* locate where the next point is to be read into */
+      /* got a match - see how long it is */
 
-         if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
-            offset  = (r * hdr->ncols);
-         else
-            offset  = (((hdr->nrows-1) - r) * hdr->ncols);
+      mlen = GEOCON_LZ_MIN_MATCH;
+      while ( ip + mlen < end && in[ref + mlen] == ip[mlen] )
+         mlen++;
 
-         if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-            offset += c;
-         else
-            offset += ((hdr->ncols-1) - c);
+      /* write the literals and the match */
 
-         p = hdr->points + offset;
+      lits  = (size_t)(ip - anchor);
+      token = op++;
+      *token = (unsigned char)(GEOCON_MIN(lits, 15) << 4);
+      if ( lits >= 15 )
+         op = gc_lz_put_len(op, lits - 15);
+      memcpy(op, anchor, lits);
+      op += lits;
 
-         /* now read into it & byte-swap it if necessary */
+      *op++ = (unsigned char)( ((size_t)(ip - in) - ref)       & 0xff);
+      *op++ = (unsigned char)((((size_t)(ip - in) - ref) >> 8) & 0xff);
 
-         nr = fread(p, sizeof(*p), 1, hdr->fp);
-         if ( nr != 1 )
-         {
-            *prc = GEOCON_ERR_IOERR;
-            rc = -1;
-            break;
-         }
+      *token |= (unsigned char)GEOCON_MIN(mlen - GEOCON_LZ_MIN_MATCH, 15);
+      if ( mlen - GEOCON_LZ_MIN_MATCH >= 15 )
+         op = gc_lz_put_len(op, mlen - GEOCON_LZ_MIN_MATCH - 15);
 
-         if ( hdr->flip )
-         {
-            gc_flip_point(p);
-         }
-      }
+      ip    += mlen;
+      anchor = ip;
    }
 
-   return rc;
+   /* write the last literals */
+   {
+      size_t lits = (size_t)(end - anchor);
+
+      *op++ = (unsigned char)(GEOCON_MIN(lits, 15) << 4);
+      if ( lits >= 15 )
+         op = gc_lz_put_len(op, lits - 15);
+      memcpy(op, anchor, lits);
+      op += lits;
+   }
+
+   return (size_t)(op - out);
 }
 
 /*------------------------------------------------------------------------
- * load ascii data
+ * decompress a buffer
+ *
+ * Returns 0 if the data decompressed to exactly "len" bytes.
  */
-static int gc_load_data_asc(
-   GEOCON_HDR    *hdr,
-   GEOCON_EXTENT *ext,
-   int           *prc)
+static int gc_lz_decompress(
+   const unsigned char *in,
+   size_t               in_len,
+   unsigned char       *out,
+   size_t               len)
 {
-   GEOCON_TOKEN tok;
-   int r;
-   int c;
-   int rc = 0;
+   const unsigned char * ip   = in;
+   const unsigned char * iend = in  + in_len;
+   unsigned char *       op   = out;
+   unsigned char *       oend = out + len;
 
-   GEOCON_UNUSED_PARAMETER(ext);
+   for (;;)
+   {
+      size_t lits;
+      size_t mlen;
+      size_t offset;
+      int    token;
 
-   /* allocate memory for the point array */
+      if ( ip >= iend )
+         return -1;
+      token = *ip++;
 
-   hdr->points = (GEOCON_POINT *)
-                 gc_memalloc(hdr->nrows * hdr->ncols * sizeof(*hdr->points));
-   if ( hdr->points == GEOCON_NULL )
-   {
-      *prc = GEOCON_ERR_NO_MEMORY;
-      return -1;
-   }
+      /* copy the literals */
+
+      lits = (size_t)(token >> 4);
+      if ( lits == 15 )
+      {
+         int c;
+         do
+         {
+            if ( ip >= iend )
+               return -1;
+            c = *ip++;
+            lits += (size_t)c;
+         } while ( c == 255 );
+      }
 
-   /* read in all points */
+      if ( lits > (size_t)(iend - ip) || lits > (size_t)(oend - op) )
+         return -1;
+      memcpy(op, ip, lits);
+      ip += lits;
+      op += lits;
 
-   for (r = 0; r < hdr->nrows; r++)
-   {
-      for (c = 0; c < hdr->ncols; c++)
+      if ( ip == iend )
+         return (op == oend) ? 0 : -1;
+
+      /* copy the match */
+
+      if ( iend - ip < 2 )
+         return -1;
+      offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+      ip += 2;
+
+      mlen = (size_t)(token & 15);
+      if ( mlen == 15 )
       {
-         GEOCON_POINT * p = GEOCON_NULL;
-         int offset;
+         int c;
+         do
+         {
+            if ( ip >= iend )
+               return -1;
+            c = *ip++;
+            mlen += (size_t)c;
+         } while ( c == 255 );
+      }
+      mlen += GEOCON_LZ_MIN_MATCH;
 
-         /* locate where the next point is to be read into */
+      if ( offset == 0 || offset > (size_t)(op - out) ||
+           mlen > (size_t)(oend - op) )
+      {
+         return -1;
+      }
 
-         if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
-            offset  = (r * hdr->ncols);
-         else
-            offset  = (((hdr->nrows-1) - r) * hdr->ncols);
+      /* the match may overlap what it is copied to */
+      {
+         const unsigned char * m = op - offset;
 
-         if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-            offset += c;
-         else
-            offset += ((hdr->ncols-1) - c);
+         for (; mlen > 0; mlen--)
+            *op++ = *m++;
+      }
+   }
+}
 
-         p = hdr->points + offset;
+/*------------------------------------------------------------------------
+ * shuffle & delta-encode a block of points
+ */
+static void gc_pack_shuffle(
+   const unsigned char *in,
+   unsigned char       *out,
+   size_t               npts,
+   size_t               len)
+{
+   size_t b;
 
-         /* now read into it */
+   for (b = 0; b < len; b++)
+   {
+      const unsigned char * p = in + b;
+      unsigned char prev = 0;
+      size_t i;
 
-         RT(3);
-         p->lat_value = (float)gc_atod( TOK(0) );
-         p->lon_value = (float)gc_atod( TOK(1) );
-         p->hgt_value = (float)gc_atod( TOK(2) );
+      for (i = 0; i < npts; i++, p += len)
+      {
+         *out++ = (unsigned char)(*p - prev);
+         prev   = *p;
       }
    }
+}
 
-   return rc;
+/*------------------------------------------------------------------------
+ * delta-decode & unshuffle a block of points
+ */
+static void gc_pack_unshuffle(
+   const unsigned char *in,
+   unsigned char       *out,
+   size_t               npts,
+   size_t               len)
+{
+   size_t b;
+
+   for (b = 0; b < len; b++)
+   {
+      unsigned char * p = out + b;
+      unsigned char prev = 0;
+      size_t i;
+
+      for (i = 0; i < npts; i++, p += len)
+      {
+         prev = (unsigned char)(prev + *in++);
+         *p   = prev;
+      }
+   }
 }
 
 /*------------------------------------------------------------------------
- * load data
+ * state for reading a packed or tiled file
+ *
+ * The points in such a file are in blocks, which are either bands of
+ * whole rows (in a packed file) or tiles (in a tiled file), and which
+ * are numbered across and then up (in file order).  The blocks of a
+ * packed file are compressed.  The blocks of a file that isn't packed
+ * are read from directly, just as a classic file is, with no cache or
+ * mutex.
+ *
+ * For a packed file, the cache holds the GEOCON_PACK_CACHE most-recently
+ * used (decompressed) blocks, and the mutex protects it.  The mutex is
+ * not held while a block is read and decompressed, which is done in
+ * buffers of the caller's own.  If two threads read the same block at
+ * once, the second one to finish just discards its copy.
  */
-static int gc_load_data(
-   GEOCON_HDR    *hdr,
-   GEOCON_EXTENT *ext,
-   int           *prc)
+typedef struct geocon_blocks GEOCON_BLOCKS;
+struct geocon_blocks
 {
-   if ( hdr->filetype == GEOCON_FILE_TYPE_BIN )
-      return gc_load_data_bin(hdr, ext, prc);
-   else
-      return gc_load_data_asc(hdr, ext, prc);
+   int             block_rows;       /* rows    in a block               */
+   int             block_cols;       /* columns in a block               */
+   int             nbcols;           /* number of blocks across          */
+   int             nblocks;          /* number of blocks                 */
+   GEOCON_BOOL     packed;           /* TRUE if blocks are compressed    */
+   size_t          block_len;        /* bytes in a full block            */
+   size_t          max_len;          /* bytes in the largest file block  */
+   GEOCON_OFFSET * offsets;          /* file offsets of the blocks       */
+
+   void *          mutex;            /* MUTEX for the following (packed) */
+   unsigned long   clock;            /* count of block lookups           */
+   int             index[GEOCON_PACK_CACHE];  /* block in slot or -1     */
+   unsigned long   used [GEOCON_PACK_CACHE];  /* when slot was last used */
+   unsigned char * data [GEOCON_PACK_CACHE];  /* block of points         */
+};
+
+static void gc_blocks_delete(
+   GEOCON_BLOCKS *blk)
+{
+   int i;
+
+   for (i = 0; i < GEOCON_PACK_CACHE; i++)
+      gc_memdealloc(blk->data[i]);
+
+   if ( blk->mutex != GEOCON_NULL )
+      gc_mutex_delete(blk->mutex);
+
+   gc_memdealloc(blk->offsets);
+   gc_memdealloc(blk);
 }
 
-/* -------------------------------------------------------------------------- */
-/* internal write routines                                                    */
-/* -------------------------------------------------------------------------- */
+/*------------------------------------------------------------------------
+ * get the number of rows & columns in a block
+ */
+static size_t gc_blocks_size(
+   const GEOCON_HDR    *hdr,
+   const GEOCON_BLOCKS *blk,
+   int                  b,
+   int                 *nrows,
+   int                 *ncols)
+{
+   int r = (b / blk->nbcols) * blk->block_rows;
+   int c = (b % blk->nbcols) * blk->block_cols;
+
+   *nrows = GEOCON_MIN(blk->block_rows, hdr->fhdr.nrows - r);
+   *ncols = GEOCON_MIN(blk->block_cols, hdr->fhdr.ncols - c);
+
+   return (size_t)(*nrows) * (size_t)(*ncols);
+}
 
 /*------------------------------------------------------------------------
- * write a binary file
+ * read the block index of a packed or tiled file
+ *
+ * The stream must be positioned at the block index.
  */
-static int gc_write_bin(
-   const GEOCON_HDR *hdr,
-   const char       *pathname,
-   int               byte_order,
-   int              *prc)
+static int gc_blocks_load(
+   GEOCON_HDR *hdr,
+   int        *prc)
 {
-   GEOCON_BOOL swap_data;
-   FILE *fp;
+   GEOCON_BLOCKS * blk;
+   size_t plen    = gc_point_len(hdr);
+   int    block_rows;
+   int    block_cols;
+   int    nblocks;
+   int    nbcols;
+   int    i;
+
+   if ( hdr->fhdr.nrows <= 0 || hdr->fhdr.ncols <= 0 )
+   {
+      *prc = GEOCON_ERR_INVALID_FILE;
+      return -1;
+   }
 
-   swap_data = hdr->flip;
-   switch (byte_order)
+   if ( (hdr->fhdr.data_fmt & GEOCON_DATA_TILED) != 0 )
    {
-      case GEOCON_ENDIAN_BIG:    swap_data ^= !gc_is_big_endian(); break;
-      case GEOCON_ENDIAN_LITTLE: swap_data ^= !gc_is_ltl_endian(); break;
-      case GEOCON_ENDIAN_NATIVE: swap_data  = FALSE;               break;
+      GEOCON_TILE_HDR thdr;
+
+      if ( fread(&thdr, sizeof(thdr), 1, hdr->fp) != 1 )
+      {
+         *prc = GEOCON_ERR_IOERR;
+         return -1;
+      }
+
+      if ( hdr->flip )
+      {
+         gc_swap_int(&thdr.tile_rows, 1);
+         gc_swap_int(&thdr.tile_cols, 1);
+         gc_swap_int(&thdr.ntiles,    1);
+      }
+
+      block_rows = thdr.tile_rows;
+      block_cols = thdr.tile_cols;
+      nblocks    = thdr.ntiles;
    }
+   else
+   {
+      GEOCON_BLOCK_HDR bhdr;
 
-   fp = fopen(pathname, "wb");
-   if ( fp == GEOCON_NULL )
+      if ( fread(&bhdr, sizeof(bhdr), 1, hdr->fp) != 1 )
+      {
+         *prc = GEOCON_ERR_IOERR;
+         return -1;
+      }
+
+      if ( hdr->flip )
+      {
+         gc_swap_int(&bhdr.block_rows, 1);
+         gc_swap_int(&bhdr.nblocks,    1);
+      }
+
+      block_rows = bhdr.block_rows;
+      block_cols = hdr->fhdr.ncols;
+      nblocks    = bhdr.nblocks;
+   }
+
+   if ( block_rows <= 0 || block_cols <= 0 )
    {
-      *prc = GEOCON_ERR_CANNOT_OPEN_FILE;
+      *prc = GEOCON_ERR_INVALID_FILE;
       return -1;
    }
 
-   /* write file header */
+   nbcols = (hdr->fhdr.ncols + block_cols - 1) / block_cols;
+   if ( nblocks != ((hdr->fhdr.nrows + block_rows - 1) / block_rows) * nbcols )
    {
-      GEOCON_FILE_HDR fhdr;
+      *prc = GEOCON_ERR_INVALID_FILE;
+      return -1;
+   }
 
-      memcpy(&fhdr, &hdr->fhdr, sizeof(fhdr));
+   blk = (GEOCON_BLOCKS *)gc_memalloc(sizeof(*blk));
+   if ( blk == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return -1;
+   }
+   memset(blk, 0, sizeof(*blk));
+   hdr->blocks = (void *)blk;
+
+   blk->block_rows = block_rows;
+   blk->block_cols = block_cols;
+   blk->nbcols     = nbcols;
+   blk->nblocks    = nblocks;
+   blk->packed     = ((hdr->fhdr.data_fmt & GEOCON_DATA_PACKED) != 0);
+   blk->block_len  = (size_t)block_rows * (size_t)block_cols * plen;
+   for (i = 0; i < GEOCON_PACK_CACHE; i++)
+      blk->index[i] = -1;
+
+   blk->offsets = (GEOCON_OFFSET *)
+                  gc_memalloc((nblocks + 1) * sizeof(*blk->offsets));
+   if ( blk->offsets == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return -1;
+   }
 
-      fhdr.lat_dir    = hdr->lat_dir;
-      fhdr.lon_dir    = hdr->lon_dir;
-      fhdr.nrows      = hdr->nrows;
-      fhdr.ncols      = hdr->ncols;
-      fhdr.lat_south  = hdr->lat_min;
-      fhdr.lat_north  = hdr->lat_max;
-      fhdr.lon_west   = hdr->lon_min;
-      fhdr.lon_east   = hdr->lon_max;
+   if ( fread(blk->offsets, sizeof(*blk->offsets), nblocks + 1,
+              hdr->fp) != (size_t)(nblocks + 1) )
+   {
+      *prc = GEOCON_ERR_IOERR;
+      return -1;
+   }
 
-      if ( swap_data )
+   if ( hdr->flip )
+      gc_swap_off(blk->offsets, nblocks + 1);
+
+   /* The blocks must be in order, and no bigger than they can be.
+      Blocks that are not compressed must be exactly their size. */
+
+   for (i = 0; i < nblocks; i++)
+   {
+      GEOCON_OFFSET len = blk->offsets[i + 1] - blk->offsets[i];
+      GEOCON_OFFSET max;
+      int nr;
+      int nc;
+
+      max = (GEOCON_OFFSET)(gc_blocks_size(hdr, blk, i, &nr, &nc) * plen);
+      if ( blk->packed )
+         max = (GEOCON_OFFSET)gc_lz_bound((size_t)max);
+
+      if ( blk->offsets[i] < 0 || len <= 0 || len > max ||
+           (!blk->packed && len != max) )
       {
-         gc_flip_hdr(&fhdr);
+         *prc = GEOCON_ERR_INVALID_FILE;
+         return -1;
       }
-      fwrite(&fhdr, sizeof(fhdr), 1, fp);
+      blk->max_len = GEOCON_MAX(blk->max_len, (size_t)len);
    }
 
-   /* write data points */
+   if ( blk->packed )
    {
-      int r;
-      int c;
-
-      for (r = 0; r < hdr->nrows; r++)
+      blk->mutex = (void *)gc_mutex_create();
+      if ( blk->mutex == GEOCON_NULL )
       {
-         for (c = 0; c < hdr->ncols; c++)
-         {
-            GEOCON_POINT pt;
-            const GEOCON_POINT * p;
-            int offset;
+         *prc = GEOCON_ERR_NO_MEMORY;
+         return -1;
+      }
+   }
 
-            /* get location of next point to write */
+   return 0;
+}
 
-            if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
-               offset  = (r * hdr->ncols);
-            else
-               offset  = (((hdr->nrows-1) - r) * hdr->ncols);
+/*------------------------------------------------------------------------
+ * copy rows of points from one array to another
+ */
+static void gc_copy_rows(
+   unsigned char       *dst,
+   size_t               dst_len,
+   const unsigned char *src,
+   size_t               src_len,
+   int                  nrows,
+   size_t               row_len)
+{
+   int r;
 
-            if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-               offset += c;
-            else
-               offset += ((hdr->ncols-1) - c);
+   for (r = 0; r < nrows; r++)
+      memcpy(dst + (r * dst_len), src + (r * src_len), row_len);
+}
+
+/*------------------------------------------------------------------------
+ * find a block in the cache
+ *
+ * The block's mutex must be held.  Returns null if it isn't there.
+ */
+static const unsigned char * gc_blocks_find(
+   GEOCON_BLOCKS    *blk,
+   int               b)
+{
+   int i;
 
-            p = hdr->points + offset;
+   blk->clock++;
 
-            if ( swap_data )
-            {
-               pt = *p;
-               p  = &pt;
-               gc_flip_point(&pt);
-            }
-            fwrite(p, sizeof(*p), 1, fp);
-         }
+   for (i = 0; i < GEOCON_PACK_CACHE; i++)
+   {
+      if ( blk->index[i] == b )
+      {
+         blk->used[i] = blk->clock;
+         return blk->data[i];
       }
    }
 
-   fclose(fp);
-   return 0;
+   return GEOCON_NULL;
 }
 
 /*------------------------------------------------------------------------
- * write an ascii file
+ * add a block to the cache
+ *
+ * The block's mutex must be held.  The block's buffer goes into the
+ * least-recently used slot, and "*pdata" is set to the buffer that was
+ * there (which may be null).  If the block is already there (since another
+ * thread read it too), nothing changes.
  */
-static int gc_write_asc(
-   const GEOCON_HDR *hdr,
-   const char       *pathname,
-   int              *prc)
+static void gc_blocks_put(
+   GEOCON_BLOCKS    *blk,
+   int               b,
+   unsigned char   **pdata)
 {
-   FILE *fp;
+   unsigned char * old;
+   int slot = 0;
+   int i;
 
-   fp = fopen(pathname, "w");
-   if ( fp == GEOCON_NULL )
+   for (i = 0; i < GEOCON_PACK_CACHE; i++)
    {
-      *prc = GEOCON_ERR_CANNOT_OPEN_FILE;
-      return -1;
+      if ( blk->index[i] == b )
+         return;
+      if ( blk->used[i] < blk->used[slot] )
+         slot = i;
    }
 
-   /* write file header */
-   {
-      const GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
-
-      fprintf(fp, "info             \"%s\"\n", fhdr->info            );
-      fprintf(fp, "source           \"%s\"\n", fhdr->source          );
-      fprintf(fp, "date             \"%s\"\n", fhdr->date            );
-      fprintf(fp, "\n");
-
-      fprintf(fp, "lat_dir          %s\n",  hdr->lat_dir == GEOCON_LAT_S_TO_N ?
-                                            "S-N" : "N-S"            );
-      fprintf(fp, "lon_dir          %s\n",  hdr->lon_dir == GEOCON_LON_E_TO_W ?
-                                            "E-W" : "W-E"            );
-
-      fprintf(fp, "nrows            %d\n",      hdr->nrows           );
-      fprintf(fp, "ncols            %d\n",      hdr->ncols           );
-      fprintf(fp, "\n");
-
-      fprintf(fp, "lat_south        %.17g\n",   hdr->lat_min         );
-      fprintf(fp, "lat_north        %.17g\n",   hdr->lat_max         );
-
-      fprintf(fp, "lon_west         %.17g\n",   hdr->lon_min         );
-      fprintf(fp, "lon_east         %.17g\n",   hdr->lon_max         );
-
-      fprintf(fp, "lat_delta        %.17g\n",  fhdr->lat_delta       );
-      fprintf(fp, "lon_delta        %.17g\n",  fhdr->lon_delta       );
-      fprintf(fp, "\n");
-
-      fprintf(fp, "horz_scale       %.17g\n",  fhdr->horz_scale      );
-      fprintf(fp, "vert_scale       %.17g\n",  fhdr->vert_scale      );
-      fprintf(fp, "\n");
-
-      fprintf(fp, "from_gcs         \"%s\"\n", fhdr->from_gcs        );
-      fprintf(fp, "from_vcs         \"%s\"\n", fhdr->from_vcs        );
-      fprintf(fp, "from_semi_major  %.17g\n",  fhdr->from_semi_major );
-      fprintf(fp, "from_flattening  %.17g\n",  fhdr->from_flattening );
-      fprintf(fp, "\n");
+   old = blk->data[slot];
+   blk->data [slot] = *pdata;
+   blk->index[slot] = b;
+   blk->used [slot] = blk->clock;
+   *pdata = old;
+}
 
-      fprintf(fp, "to_gcs           \"%s\"\n", fhdr->to_gcs          );
-      fprintf(fp, "to_vcs           \"%s\"\n", fhdr->to_vcs          );
-      fprintf(fp, "to_semi_major    %.17g\n",  fhdr->to_semi_major   );
-      fprintf(fp, "to_flattening    %.17g\n",  fhdr->to_flattening   );
+/*------------------------------------------------------------------------
+ * read a packed block from the file
+ *
+ * The block is read and decompressed into "data", using "buf" for the
+ * compressed block and its shuffled points.  Both buffers are allocated
+ * if null.  No lock is held unless the OS can't do a positional read.
+ */
+static int gc_blocks_fetch(
+   const GEOCON_HDR *hdr,
+   GEOCON_BLOCKS    *blk,
+   int               b,
+   unsigned char   **pbuf,
+   unsigned char   **pdata)
+{
+   size_t plen = gc_point_len(hdr);
+   size_t npts;
+   size_t clen;
+   unsigned char * sbuf;
+   int    nr;
+   int    nc;
+   int    rc;
+
+   if ( *pdata == GEOCON_NULL )
+   {
+      *pdata = (unsigned char *)gc_memalloc(blk->block_len);
+      if ( *pdata == GEOCON_NULL )
+         return -1;
    }
 
-   /* write data points */
+   if ( *pbuf == GEOCON_NULL )
    {
-      int r;
-      int c;
-
-      for (r = 0; r < hdr->nrows; r++)
-      {
-         fprintf(fp, "\n");
-         for (c = 0; c < hdr->ncols; c++)
-         {
-            const GEOCON_POINT * p;
-            char buf_lat[24];
-            char buf_lon[24];
-            char buf_hgt[24];
-            int offset;
-
-            /* get location of next point to write */
-
-            if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
-               offset  = (r * hdr->ncols);
-            else
-               offset  = (((hdr->nrows-1) - r) * hdr->ncols);
+      *pbuf = (unsigned char *)gc_memalloc(blk->max_len + blk->block_len);
+      if ( *pbuf == GEOCON_NULL )
+         return -1;
+   }
 
-            if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-               offset += c;
-            else
-               offset += ((hdr->ncols-1) - c);
+   npts = gc_blocks_size(hdr, blk, b, &nr, &nc);
+   clen = (size_t)(blk->offsets[b + 1] - blk->offsets[b]);
+   sbuf = *pbuf + blk->max_len;
 
-            p = hdr->points + offset;
+#ifdef GEOCON_READ_AT_NEEDS_LOCK
+   gc_mutex_enter(hdr->mutex);
+#endif
+   rc = gc_read_at(hdr->fp, *pbuf, clen, blk->offsets[b]);
+#ifdef GEOCON_READ_AT_NEEDS_LOCK
+   gc_mutex_leave(hdr->mutex);
+#endif
 
-            fprintf(fp, "%16s %16s %16s\n",
-               gc_dtoa(buf_lat, p->lat_value),
-               gc_dtoa(buf_lon, p->lon_value),
-               gc_dtoa(buf_hgt, p->hgt_value) );
-         }
-      }
-   }
+   if ( rc == 0 )
+      rc = gc_lz_decompress(*pbuf, clen, sbuf, npts * plen);
+   if ( rc == 0 )
+      gc_pack_unshuffle(sbuf, *pdata, npts, plen);
 
-   fclose(fp);
-   return 0;
+   return rc;
 }
 
-/* -------------------------------------------------------------------------- */
-/* internal transformation routines                                           */
-/* -------------------------------------------------------------------------- */
-
 /*------------------------------------------------------------------------
- * Get a lat/lon shift value (either from a file or from memory).
+ * read part of a tile that isn't packed from the file
+ *
+ * The part is "nrows" rows of "row_len" bytes, starting "from" bytes into
+ * the tile, which are read into "dst" at "dst_len" bytes apart.  If whole
+ * rows of the tile are wanted, they are contiguous, and are read all at
+ * once (into "data" if need be, which is allocated if null).  Otherwise,
+ * each row is read on its own.  As with gc_read_span(), no lock is held
+ * unless the OS can't do a positional read.
  */
-static void gc_get_shift_from_file(
-   const GEOCON_HDR * hdr,
-   GEOCON_POINT *     pt,
-   int                irow,
-   int                icol)
+static int gc_blocks_read_tile(
+   const GEOCON_HDR *hdr,
+   GEOCON_BLOCKS    *blk,
+   int               b,
+   size_t            from,
+   size_t            tile_len,
+   unsigned char    *dst,
+   size_t            dst_len,
+   int               nrows,
+   size_t            row_len,
+   unsigned char   **pdata)
 {
-   size_t nr = 0;
+   GEOCON_OFFSET offset = blk->offsets[b] + (GEOCON_OFFSET)from;
+   GEOCON_BOOL whole = (row_len == tile_len && nrows > 1);
+   int rc = 0;
+   int r;
 
-   if ( hdr->fp != GEOCON_NULL )
+   if ( whole && dst_len != row_len && *pdata == GEOCON_NULL )
    {
-      long offset;
-
-      /* get the file offset to the point to be read */
-
-      if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
-         offset  = (irow * hdr->ncols);
-      else
-         offset  = (((hdr->nrows-1) - irow) * hdr->ncols);
-
-      if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
-         offset += icol;
-      else
-         offset += ((hdr->ncols-1) - icol);
-
-      offset = hdr->points_start + (offset * sizeof(*pt));
-
-      /* do the [thread-protected] read */
-
-      gc_mutex_enter(hdr->mutex);
-      {
-         fseek(hdr->fp, offset, SEEK_SET);
-         nr = fread(pt, sizeof(*pt), 1, hdr->fp);
-      }
-      gc_mutex_leave(hdr->mutex);
+      *pdata = (unsigned char *)gc_memalloc(blk->block_len);
+      if ( *pdata == GEOCON_NULL )
+         return -1;
    }
 
-   if ( nr != 1 )
+#ifdef GEOCON_READ_AT_NEEDS_LOCK
+   gc_mutex_enter(hdr->mutex);
+#endif
+   if ( whole && dst_len == row_len )
    {
-      pt->lat_value = 0.0;
-      pt->lon_value = 0.0;
-      pt->hgt_value = 0.0;
+      rc = gc_read_at(hdr->fp, dst, nrows * row_len, offset);
    }
    else
+   if ( whole )
    {
-      if ( hdr->flip )
-      {
-         gc_flip_point(pt);
-      }
-   }
-}
-
-static void gc_get_shift_from_data(
-   const GEOCON_HDR * hdr,
-   GEOCON_POINT *     pt,
-   int                irow,
-   int                icol)
-{
-   int offset = (irow * hdr->ncols) + icol;
-
-   *pt = hdr->points[offset];
-}
-
-static void gc_get_shift(
-   const GEOCON_HDR * hdr,
-   GEOCON_POINT *     pt,
-   int                irow,
-   int                icol)
-{
-   if ( irow < 0 || irow >= hdr->nrows ||
-        icol < 0 || icol >= hdr->ncols )
-   {
-      pt->lat_value = 0.0;
-      pt->lon_value = 0.0;
-      pt->hgt_value = 0.0;
+      rc = gc_read_at(hdr->fp, *pdata, nrows * row_len, offset);
+      if ( rc == 0 )
+         gc_copy_rows(dst, dst_len, *pdata, row_len, nrows, row_len);
    }
    else
    {
-      if ( hdr->points != GEOCON_NULL )
-      {
-         gc_get_shift_from_data(hdr, pt, irow, icol);
-      }
-      else
-      if ( hdr->fp     != GEOCON_NULL )
+      for (r = 0; rc == 0 && r < nrows; r++)
       {
-         gc_get_shift_from_file(hdr, pt, irow, icol);
-      }
-      else
-      {
-         pt->lat_value = 0.0;
-         pt->lon_value = 0.0;
-         pt->hgt_value = 0.0;
+         rc = gc_read_at(hdr->fp, dst + (r * dst_len), row_len,
+                         offset + (GEOCON_OFFSET)(r * tile_len));
       }
    }
+#ifdef GEOCON_READ_AT_NEEDS_LOCK
+   gc_mutex_leave(hdr->mutex);
+#endif
+
+   return rc;
 }
 
 /*------------------------------------------------------------------------
- * calculate the shifts for a point using bilinear interpolation
+ * read points from a packed or tiled file
+ *
+ * This reads "ncols" points starting at column "col" in each of "n" file
+ * rows starting at "row", as they are in the file, just as if they had
+ * been read from a classic file.  Each block needed is gotten once.
+ * It may be called by multiple threads.
  */
-static void gc_calculate_shifts_bilinear(
-   const GEOCON_HDR * hdr,
-   double       lat_deg,
-   double       lon_deg,
-   double *     lat_shift,
-   double *     lon_shift,
-   double *     hgt_shift)
+static int gc_blocks_read(
+   const GEOCON_HDR *hdr,
+   void             *dst,
+   int               row,
+   int               col,
+   int               n,
+   int               ncols)
 {
-   GEOCON_POINT ptA, ptB, ptC, ptD;
-   double       x_grid_index, y_grid_index, dx, dy;
-   double       h1,  h2,  h3,  h4;
-   double       a00, a01, a10, a11;
-   int          icol, irow;
+   GEOCON_BLOCKS * blk = (GEOCON_BLOCKS *)hdr->blocks;
+   size_t len = gc_point_len(hdr);
+   unsigned char * p    = (unsigned char *)dst;
+   unsigned char * buf  = GEOCON_NULL;
+   unsigned char * data = GEOCON_NULL;
+   int rc = 0;
+   int br;
+   int bc;
 
-   /* get the corner points around our point */
+   for (br = row / blk->block_rows;
+        rc == 0 && br <= (row + n - 1) / blk->block_rows; br++)
    {
-      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
-      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+      int r0 = GEOCON_MAX(row,     br      * blk->block_rows);
+      int r1 = GEOCON_MIN(row + n, (br+1) * blk->block_rows);
 
-      icol = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
-      irow = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
-
-      dx   = (x_grid_index - icol);
-      dy   = (y_grid_index - irow);
+      for (bc = col / blk->block_cols;
+           bc <= (col + ncols - 1) / blk->block_cols; bc++)
+      {
+         int b  = (br * blk->nbcols) + bc;
+         int c0 = GEOCON_MAX(col,         bc      * blk->block_cols);
+         int c1 = GEOCON_MIN(col + ncols, (bc+1) * blk->block_cols);
+         const unsigned char * cached;
+         unsigned char * to;
+         size_t from;
+         int nr;
+         int nc;
 
-      /* corner points around p are in this order:
+         /* where the first point is in the block & is to be copied to */
 
-                        points    values
-                        -----     ---------
-                        C   D     h3     h4
-                          p           p
-         (irow,icol) -> A   B     h1     h2
-      */
-      gc_get_shift(hdr, &ptA, irow  , icol  );
-      gc_get_shift(hdr, &ptB, irow  , icol+1);
-      gc_get_shift(hdr, &ptC, irow+1, icol  );
-      gc_get_shift(hdr, &ptD, irow+1, icol+1);
-   }
+         gc_blocks_size(hdr, blk, b, &nr, &nc);
+         from = (((size_t)(r0 - (br * blk->block_rows)) * nc) +
+                 (c0 - (bc * blk->block_cols))) * len;
+         to   = p + ((((size_t)(r0 - row) * ncols) + (c0 - col)) * len);
 
-   /* Longitude */
-   {
-      h1 = ptA.lon_value;
-      h2 = ptB.lon_value;
-      h3 = ptC.lon_value;
-      h4 = ptD.lon_value;
+         /* a tile that isn't packed is just read */
 
-      a00 =  h1;
-      a10 = (h2 - h1);
-      a01 = (h3 - h1);
-      a11 = (h1 - h2) - (h3 - h4);
+         if ( !blk->packed )
+         {
+            rc = gc_blocks_read_tile(hdr, blk, b, from, nc * len,
+                                     to, ncols * len,
+                                     r1 - r0, (c1 - c0) * len, &data);
+            if ( rc != 0 )
+               break;
+            continue;
+         }
 
-      *lon_shift = a00 + (a10 * dx) + (a01 * dy) + (a11 * dx * dy);
-   }
+         /* copy it from the cache if it's there */
 
-   /* Latitude */
-   {
-      h1 = ptA.lat_value;
-      h2 = ptB.lat_value;
-      h3 = ptC.lat_value;
-      h4 = ptD.lat_value;
+         gc_mutex_enter(blk->mutex);
+         {
+            cached = gc_blocks_find(blk, b);
+            if ( cached != GEOCON_NULL )
+            {
+               gc_copy_rows(to, ncols * len, cached + from, nc * len,
+                            r1 - r0, (c1 - c0) * len);
+            }
+         }
+         gc_mutex_leave(blk->mutex);
 
-      a00 =  h1;
-      a10 = (h2 - h1);
-      a01 = (h3 - h1);
-      a11 = (h1 - h2) - (h3 - h4);
+         if ( cached != GEOCON_NULL )
+            continue;
 
-      *lat_shift = a00 + (a10 * dx) + (a01 * dy) + (a11 * dx * dy);
-   }
+         /* no - read it, copy it, & add it to the cache */
 
-   /* Height */
-   {
-      h1 = ptA.hgt_value;
-      h2 = ptB.hgt_value;
-      h3 = ptC.hgt_value;
-      h4 = ptD.hgt_value;
+         rc = gc_blocks_fetch(hdr, blk, b, &buf, &data);
+         if ( rc != 0 )
+            break;
 
-      a00 =  h1;
-      a10 = (h2 - h1);
-      a01 = (h3 - h1);
-      a11 = (h1 - h2) - (h3 - h4);
+         gc_copy_rows(to, ncols * len, data + from, nc * len,
+                      r1 - r0, (c1 - c0) * len);
 
-      *hgt_shift = a00 + (a10 * dx) + (a01 * dy) + (a11 * dx * dy);
+         gc_mutex_enter(blk->mutex);
+         {
+            gc_blocks_put(blk, b, &data);
+         }
+         gc_mutex_leave(blk->mutex);
+      }
    }
+
+   gc_memdealloc(data);
+   gc_memdealloc(buf);
+
+   return rc;
 }
 
+/* -------------------------------------------------------------------------- */
+/* internal parallel task routines                                            */
+/* -------------------------------------------------------------------------- */
+
+#ifndef   GEOCON_MAX_THREADS
+#  define GEOCON_MAX_THREADS  64   /* max threads to use for one task */
+#endif
+
 /*------------------------------------------------------------------------
- * calculate the shifts for a point using bicubic interpolation
+ * get the number of threads to use for a task
+ *
+ * "size" is the size of the task and "min_size" is the smallest part
+ * of it that is worth giving to a thread.
  */
-static void gc_calculate_shifts_bicubic(
-   const GEOCON_HDR * hdr,
-   double       lat_deg,
-   double       lon_deg,
-   double *     lat_shift,
-   double *     lon_shift,
-   double *     hgt_shift)
+static int gc_num_threads(
+   size_t size,
+   size_t min_size)
 {
-   GEOCON_POINT pt[4][4];
-   double       h[4][4];
-   double       c[4];
-   double       a0, a1, a2, a3, d0, d2, d3;
-   double       x_grid_index, y_grid_index;
-   double       dx, dy;
-   int          irow, icol, ir;
-   int          i, j;
-
-   /* get the corner points around our point */
-   {
-      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
-      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+   size_t n   = (min_size == 0) ? 1 : (size / min_size);
+   int    max = GEOCON_MIN(gc_num_cpus(), GEOCON_MAX_THREADS);
 
-      icol = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
-      irow = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
+   if ( n > (size_t)max )
+      n = (size_t)max;
+   if ( n < 1 )
+      n = 1;
 
-      dx   = (x_grid_index - icol);
-      dy   = (y_grid_index - irow);
+   return (int)n;
+}
 
-      /* corner points around p are in this order:
+/*------------------------------------------------------------------------
+ * run a task on an array of "n" work items in parallel
+ *
+ * Each item is "size" bytes long, and "n" must not be greater than
+ * GEOCON_MAX_THREADS.  Item 0 is processed in the calling thread and
+ * the rest in their own threads.  Any item for which a thread cannot
+ * be created is also processed in the calling thread.
+ */
+static void gc_run_parallel(
+   GEOCON_THREAD_FUNC func,
+   void *             items,
+   size_t             size,
+   int                n)
+{
+   void * threads[GEOCON_MAX_THREADS];
+   int i;
 
-         points            values
-         -------------     ---------------------
-         M   N   O   P     h30   h31   h32   h33
+   for (i = 1; i < n; i++)
+      threads[i] = gc_thread_create(func, (char *)items + (i * size));
 
-         I   J   K   L     h20   h21   h22   h23
-               p                     p
-         E   F   G   H     h10   h11   h12   h13
+   func(items);
 
-         A   B   C   D     h00   h01   h02   h03
+   for (i = 1; i < n; i++)
+   {
+      if ( threads[i] == GEOCON_NULL )
+         func((char *)items + (i * size));
+      else
+         gc_thread_join(threads[i]);
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+/* internal read routines                                                     */
+/* -------------------------------------------------------------------------- */
+
+/*------------------------------------------------------------------------
+ * Read in a line from an ascii stream.
+ *
+ * This will read in a line, strip all leading and trailing whitespace,
+ * and discard any blank lines and comments (anything following a #).
+ *
+ * Returns NULL at EOF.
+ */
+static char * gc_read_line(GEOCON_HDR *hdr, char *buf, size_t buflen)
+{
+   char * bufp;
+
+   for (;;)
+   {
+      char *p;
+
+      bufp = fgets(buf, (int)buflen, hdr->fp);
+      if ( bufp == NULL )
+         break;
+      hdr->line_count++;
+
+      p = strchr(bufp, '#');
+      if ( p != NULL )
+         *p = 0;
+
+      bufp = gc_strip(bufp);
+      if ( *bufp != 0 )
+         break;
+   }
+
+   return bufp;
+}
+
+/*------------------------------------------------------------------------
+ * read in a tokenized line
+ *
+ * Returns number of tokens or -1 at EOF
+ */
+static int gc_read_toks(GEOCON_HDR *hdr, GEOCON_TOKEN *ptok, int maxtoks)
+{
+   char  buf[GEOCON_TOKENS_BUFLEN];
+   char *bufp;
+
+   bufp = gc_read_line(hdr, buf, sizeof(buf));
+   if ( bufp == NULL )
+      return -1;
+
+   return gc_str_tokenize(ptok, bufp, NULL, maxtoks);
+}
+
+#define RT(n)    if ( gc_read_toks(hdr, &tok, n) <= 0 )  \
+                 {                                       \
+                    *prc = GEOCON_ERR_UNEXPECTED_EOF;    \
+                    return -1;                           \
+                 }                                       \
+                 if ( tok.num != n )                     \
+                 {                                       \
+                    *prc = GEOCON_ERR_INVALID_TOKEN_CNT; \
+                    return -1;                           \
+                 }
+
+#define TOK(i)   tok.toks[i]
+
+/*------------------------------------------------------------------------
+ * load a binary header
+ */
+static int gc_load_hdr_bin(
+   GEOCON_HDR *hdr,
+   int        *prc)
+{
+   GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
+   size_t nr;
+
+   nr = fread(fhdr, sizeof(*fhdr), 1, hdr->fp);
+   if ( nr != 1 )
+   {
+      *prc = GEOCON_ERR_IOERR;
+      return -1;
+   }
+
+   if ( fhdr->magic == GEOCON_HDR_MAGIC_SWAPPED )
+   {
+      gc_flip_hdr(fhdr);
+      hdr->flip = TRUE;
+   }
+
+   if ( fhdr->magic != GEOCON_HDR_MAGIC )
+   {
+      *prc = GEOCON_ERR_INVALID_FILE;
+      return -1;
+   }
+
+   /* In version 1 the data format was a reserved field. */
+
+   switch (fhdr->version)
+   {
+      case GEOCON_HDR_VERSION:
+         fhdr->data_fmt = GEOCON_DATA_FLOAT;
+         break;
+
+      case GEOCON_HDR_VERSION_2:
+         break;
+
+      default:
+         *prc = GEOCON_ERR_INVALID_FILE;
+         return -1;
+   }
+
+   if ( (fhdr->data_fmt & ~(GEOCON_DATA_FMT_MASK |
+                            GEOCON_DATA_PACKED   |
+                            GEOCON_DATA_TILED)) != 0 )
+   {
+      *prc = GEOCON_ERR_INVALID_FILE;
+      return -1;
+   }
+   hdr->data_fmt = (fhdr->data_fmt & GEOCON_DATA_FMT_MASK);
+
+   /* quantized data has its quantization info next */
+
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+   {
+      nr = fread(&hdr->quant, sizeof(hdr->quant), 1, hdr->fp);
+      if ( nr != 1 )
+      {
+         *prc = GEOCON_ERR_IOERR;
+         return -1;
+      }
+
+      if ( hdr->flip )
+         gc_flip_quant(&hdr->quant);
+
+      if ( !gc_quant_is_valid(&hdr->quant) )
+      {
+         *prc = GEOCON_ERR_INVALID_FILE;
+         return -1;
+      }
+   }
+   else
+   if ( hdr->data_fmt != GEOCON_DATA_FLOAT )
+   {
+      *prc = GEOCON_ERR_INVALID_FILE;
+      return -1;
+   }
+
+   /* packed or tiled data has its block index next */
+
+   if ( (fhdr->data_fmt & (GEOCON_DATA_PACKED | GEOCON_DATA_TILED)) != 0 )
+   {
+      if ( gc_blocks_load(hdr, prc) != 0 )
+         return -1;
+   }
+
+   hdr->points_start = gc_ftell(hdr->fp);
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * load an ascii header
+ */
+static int gc_load_hdr_asc(
+   GEOCON_HDR *hdr,
+   int        *prc)
+{
+   GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
+   GEOCON_TOKEN tok;
+   char dec_pnt = gc_decimal_point();
+
+   RT(2); gc_strncpy( fhdr->info,           TOK(1), sizeof(fhdr->info)   );
+   RT(2); gc_strncpy( fhdr->source,         TOK(1), sizeof(fhdr->source) );
+   RT(2); gc_strncpy( fhdr->date,           TOK(1), sizeof(fhdr->date)   );
+
+   RT(2); fhdr->lat_dir      = (gc_strcmp_i(TOK(1), "N-S") == 0) ?
+                                                    GEOCON_LAT_N_TO_S :
+                                                    GEOCON_LAT_S_TO_N ;
+
+   RT(2); fhdr->lon_dir      = (gc_strcmp_i(TOK(1), "E-W") == 0) ?
+                                                    GEOCON_LON_E_TO_W :
+                                                    GEOCON_LON_W_TO_E ;
+
+   RT(2); fhdr->nrows            = atoi(    TOK(1) );
+   RT(2); fhdr->ncols            = atoi(    TOK(1) );
+
+   RT(2); fhdr->lat_south        = gc_atod( TOK(1), dec_pnt );
+   RT(2); fhdr->lat_north        = gc_atod( TOK(1), dec_pnt );
+
+   RT(2); fhdr->lon_west         = gc_atod( TOK(1), dec_pnt );
+   RT(2); fhdr->lon_east         = gc_atod( TOK(1), dec_pnt );
+
+   RT(2); fhdr->lat_delta        = gc_atod( TOK(1), dec_pnt );
+   RT(2); fhdr->lon_delta        = gc_atod( TOK(1), dec_pnt );
+
+   RT(2); fhdr->horz_scale       = gc_atod( TOK(1), dec_pnt );
+   RT(2); fhdr->vert_scale       = gc_atod( TOK(1), dec_pnt );
+
+   RT(2); gc_strncpy( fhdr->from_gcs,       TOK(1), sizeof(fhdr->from_gcs) );
+   RT(2); gc_strncpy( fhdr->from_vcs,       TOK(1), sizeof(fhdr->from_vcs) );
+   RT(2); fhdr->from_semi_major  = gc_atod( TOK(1), dec_pnt );
+   RT(2); fhdr->from_flattening  = gc_atod( TOK(1), dec_pnt );
+
+   RT(2); gc_strncpy( fhdr->to_gcs,         TOK(1), sizeof(fhdr->to_gcs)   );
+   RT(2); gc_strncpy( fhdr->to_vcs,         TOK(1), sizeof(fhdr->to_vcs)   );
+   RT(2); fhdr->to_semi_major    = gc_atod( TOK(1), dec_pnt );
+   RT(2); fhdr->to_flattening    = gc_atod( TOK(1), dec_pnt );
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * load a header
+ */
+static int gc_load_hdr(
+   GEOCON_HDR *hdr,
+   int        *prc)
+{
+   int rc;
+
+   if ( hdr->filetype == GEOCON_FILE_TYPE_BIN )
+      rc =  gc_load_hdr_bin(hdr, prc);
+   else
+      rc =  gc_load_hdr_asc(hdr, prc);
+
+   if ( rc == 0 )
+   {
+      hdr->lat_dir       = hdr->fhdr.lat_dir;
+      hdr->lon_dir       = hdr->fhdr.lon_dir;
+
+      hdr->nrows         = hdr->fhdr.nrows;
+      hdr->ncols         = hdr->fhdr.ncols;
+
+      hdr->lat_min       = hdr->fhdr.lat_south;
+      hdr->lat_max       = hdr->fhdr.lat_north;
+      hdr->lon_min       = hdr->fhdr.lon_west;
+      hdr->lon_max       = hdr->fhdr.lon_east;
+
+      hdr->lat_delta     = hdr->fhdr.lat_delta;
+      hdr->lon_delta     = hdr->fhdr.lon_delta;
+      hdr->horz_scale    = hdr->fhdr.horz_scale;
+      hdr->vert_scale    = hdr->fhdr.vert_scale;
+
+      hdr->lat_min_ghost = (hdr->lat_min - hdr->lat_delta);
+      hdr->lat_max_ghost = (hdr->lat_max + hdr->lat_delta);
+      hdr->lon_min_ghost = (hdr->lon_min - hdr->lon_delta);
+      hdr->lon_max_ghost = (hdr->lon_max + hdr->lon_delta);
+   }
+
+   return rc;
+}
+
+/*------------------------------------------------------------------------
+ * adjust a header against an extent
+ */
+static int gc_adjust_extent(
+   GEOCON_HDR    *hdr,
+   GEOCON_EXTENT *ext,
+   int           *skip_south,
+   int           *skip_north,
+   int           *skip_west,
+   int           *skip_east,
+   GEOCON_BOOL    adjust_hdr,
+   int           *prc)
+{
+   double lat_min;
+   double lat_max;
+   double lon_min;
+   double lon_max;
+   double d;
+   int k;
+
+   *skip_south  = 0;
+   *skip_north  = 0;
+   *skip_west   = 0;
+   *skip_east   = 0;
+
+   if ( ext == GEOCON_NULL )
+      return 0;
+
+   lat_min = ext->slat;
+   lat_max = ext->nlat;
+   lon_min = ext->wlon;
+   lon_max = ext->elon;
+
+   if ( GEOCON_GE( lat_min, lat_max ) ||
+        GEOCON_GE( lon_min, lon_max ) )
+   {
+      if ( prc != GEOCON_NULL )
+         *prc = GEOCON_ERR_INVALID_EXTENT;
+      return -1;
+   }
+
+   if ( GEOCON_GE( lat_min, hdr->lat_max ) ||
+        GEOCON_LE( lat_max, hdr->lat_min ) ||
+        GEOCON_GE( lon_min, hdr->lon_max ) ||
+        GEOCON_LE( lon_max, hdr->lon_min ) )
+   {
+      if ( prc != GEOCON_NULL )
+         *prc = GEOCON_ERR_INVALID_EXTENT;
+      return -1;
+   }
+
+   lat_min = GEOCON_MAX( lat_min, hdr->lat_min );
+   lat_max = GEOCON_MIN( lat_max, hdr->lat_max );
+   lon_min = GEOCON_MAX( lon_min, hdr->lon_min );
+   lon_max = GEOCON_MIN( lon_max, hdr->lon_max );
+
+   /* adjust edges of extent to match multiples of the delta */
+
+   if ( GEOCON_GT(lat_min, hdr->lat_min) )
+   {
+      d = (lat_min - hdr->lat_min) / hdr->lat_delta;
+      k = (int)floor(d);
+
+      if ( k > 0 )
+      {
+         *skip_south = k;
+         if ( adjust_hdr )
+         {
+            hdr->lat_min += (k * hdr->lat_delta);
+            hdr->nrows   -= k;
+         }
+      }
+   }
+
+   if ( GEOCON_LT(lat_max, hdr->lat_max) )
+   {
+      d = (hdr->lat_max - lat_max) / hdr->lat_delta;
+      k = (int)floor(d);
+
+      if ( k > 0 )
+      {
+         *skip_north = k;
+         if ( adjust_hdr )
+         {
+            hdr->lat_max -= (k * hdr->lat_delta);
+            hdr->nrows   -= k;
+         }
+      }
+   }
+
+   if ( GEOCON_GT(lon_min, hdr->lon_min) )
+   {
+      d = (lon_min - hdr->lon_min) / hdr->lon_delta;
+      k = (int)floor(d);
+
+      if ( k > 0 )
+      {
+         *skip_west = k;
+         if ( adjust_hdr )
+         {
+            hdr->lon_min += (k * hdr->lon_delta);
+            hdr->ncols   -= k;
+         }
+      }
+   }
+
+   if ( GEOCON_LT(lon_max, hdr->lon_max) )
+   {
+      d = (hdr->lon_max - lon_max) / hdr->lon_delta;
+      k = (int)floor(d);
+
+      if ( k > 0 )
+      {
+         *skip_east = k;
+         if ( adjust_hdr )
+         {
+            hdr->lon_max -= (k * hdr->lon_delta);
+            hdr->ncols   -= k;
+         }
+      }
+   }
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * byte-swap and reorder a block of rows just read in
+ *
+ * The block consists of "n" rows as they were in the file, which have
+ * been read into the location they will finally occupy in memory.
+ */
+static void gc_fix_rows(
+   const GEOCON_HDR *hdr,
+   void             *rows,
+   int               n)
+{
+   GEOCON_POINT * p = (GEOCON_POINT *)rows;
+   int i;
+
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+   {
+      size_t len = gc_point_len(hdr);
+
+      if ( hdr->flip )
+         gc_flip_qpoints(&hdr->quant, rows, (size_t)n * hdr->ncols);
+
+      if ( hdr->lon_dir == GEOCON_LON_E_TO_W )
+      {
+         for (i = 0; i < n; i++)
+            gc_reverse_qrow((unsigned char *)rows +
+                            ((size_t)i * hdr->ncols * len), hdr->ncols, len);
+      }
+
+      if ( hdr->lat_dir == GEOCON_LAT_N_TO_S )
+         gc_reverse_qrows(rows, n, hdr->ncols, len);
+
+      return;
+   }
+
+   if ( hdr->flip )
+   {
+      gc_flip_points(p, n * hdr->ncols);
+   }
+
+   if ( hdr->lon_dir == GEOCON_LON_E_TO_W )
+   {
+      for (i = 0; i < n; i++)
+         gc_reverse_row(p + ((size_t)i * hdr->ncols), hdr->ncols);
+   }
+
+   if ( hdr->lat_dir == GEOCON_LAT_N_TO_S )
+   {
+      gc_reverse_rows(p, n, hdr->ncols);
+   }
+}
+
+/*------------------------------------------------------------------------
+ * allocate the points array (or quantized points array)
+ */
+static unsigned char * gc_alloc_points(
+   GEOCON_HDR    *hdr,
+   int           *prc)
+{
+   unsigned char * data;
+
+   data = (unsigned char *)
+          gc_memalloc((size_t)hdr->nrows * hdr->ncols * gc_point_len(hdr));
+   if ( data == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return GEOCON_NULL;
+   }
+
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+      hdr->qpoints = (void *)data;
+   else
+      hdr->points  = (GEOCON_POINT *)data;
+
+   return data;
+}
+
+/*------------------------------------------------------------------------
+ * load binary data, processing it against an extent
+ *
+ * The part of each file row that we want is contiguous in the file, so
+ * each row span is read with one positional read directly into its
+ * place in the points array.  If no columns are cut out, the spans of
+ * successive rows are contiguous too, and are read in blocks of rows.
+ * If the file is packed or tiled, the spans are copied from the blocks
+ * they are in instead, a band of blocks at a time, so only the blocks
+ * needed are read, and each of them only once.
+ */
+#ifndef   GEOCON_READ_BLOCK_SIZE
+#  define GEOCON_READ_BLOCK_SIZE  (1024 * 1024)  /* bytes per read */
+#endif
+
+static int gc_load_data_ext(
+   GEOCON_HDR    *hdr,
+   GEOCON_EXTENT *ext,
+   int           *prc)
+{
+   GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
+   size_t len = gc_point_len(hdr);
+   unsigned char * data;
+   size_t row_size;
+   int  rows_per_read;
+   int  first_row;
+   int  first_col;
+   int  skip_south = 0;
+   int  skip_north = 0;
+   int  skip_west  = 0;
+   int  skip_east  = 0;
+   int  r;
+   int  n;
+   int  rc = 0;
+
+   /* Calculate the amount of data to cut out
+      and update header (not file header) values.
+   */
+   rc = gc_adjust_extent(hdr, ext,
+      &skip_south, &skip_north, &skip_west, &skip_east, TRUE, prc);
+   if ( rc != 0 )
+      return rc;
+
+   /* allocate the points array */
+
+   data = gc_alloc_points(hdr, prc);
+   if ( data == GEOCON_NULL )
+      return -1;
+
+   /* get the first file row & column to be read */
+
+   if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
+      first_row = skip_south;
+   else
+      first_row = skip_north;
+
+   if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
+      first_col = skip_west;
+   else
+      first_col = skip_east;
+
+   row_size = hdr->ncols * len;
+   if ( hdr->ncols == fhdr->ncols )
+      rows_per_read = (int)(GEOCON_READ_BLOCK_SIZE / row_size);
+   else
+      rows_per_read = 1;
+   if ( rows_per_read < 1 )
+      rows_per_read = 1;
+
+   /* Now read in the row spans.  Note that we may not read all
+      the way to the end of the file.
+   */
+   for (r = 0; r < hdr->nrows; r += n)
+   {
+      unsigned char * p;
+      GEOCON_OFFSET offset;
+
+      n = GEOCON_MIN(rows_per_read, hdr->nrows - r);
+      if ( hdr->blocks != GEOCON_NULL )
+      {
+         int block_rows = ((GEOCON_BLOCKS *)hdr->blocks)->block_rows;
+
+         n = GEOCON_MIN(block_rows - ((first_row + r) % block_rows),
+                        hdr->nrows - r);
+      }
+
+      /* locate where this span is in the file & is to be read into */
+
+      offset = ((GEOCON_OFFSET)(first_row + r) * fhdr->ncols) + first_col;
+      offset = hdr->points_start + (offset * (GEOCON_OFFSET)len);
+
+      if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
+         p = data + ((size_t)r * row_size);
+      else
+         p = data + ((size_t)(hdr->nrows - r - n) * row_size);
+
+      /* now read into it & byte-swap and reorder it if necessary */
+
+      if ( hdr->blocks != GEOCON_NULL )
+         rc = gc_blocks_read(hdr, p, first_row + r, first_col, n, hdr->ncols);
+      else
+         rc = gc_read_at(hdr->fp, p, n * row_size, offset);
+
+      if ( rc != 0 )
+      {
+         *prc = GEOCON_ERR_IOERR;
+         return -1;
+      }
+
+      gc_fix_rows(hdr, p, n);
+   }
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * load binary data
+ *
+ * The data is read in blocks of whole rows, each of which is read
+ * directly into its final location in the points array.  Any
+ * byte-swapping and reordering is then done on the block while it is
+ * still in the cache.
+ */
+static int gc_load_data_bin(
+   GEOCON_HDR    *hdr,
+   GEOCON_EXTENT *ext,
+   int           *prc)
+{
+   unsigned char * data;
+   size_t row_size;
+   int    rows_per_read;
+   int    r;
+
+   if ( !gc_extent_is_empty(ext) )
+   {
+      return gc_load_data_ext(hdr, ext, prc);
+   }
+
+   if ( hdr->blocks != GEOCON_NULL )
+   {
+      return gc_load_data_ext(hdr, GEOCON_NULL, prc);
+   }
+
+   /* allocate memory for the point array */
+
+   data = gc_alloc_points(hdr, prc);
+   if ( data == GEOCON_NULL )
+      return -1;
+
+   row_size      = hdr->ncols * gc_point_len(hdr);
+   rows_per_read = (int)(GEOCON_READ_BLOCK_SIZE / row_size);
+   if ( rows_per_read < 1 )
+      rows_per_read = 1;
+
+   /* read in all points, a block of rows at a time */
+
+   for (r = 0; r < hdr->nrows; r += rows_per_read)
+   {
+      unsigned char * p;
+      size_t nr;
+      int    n = GEOCON_MIN(rows_per_read, hdr->nrows - r);
+
+      /* locate where this block of rows is to be read into */
+
+      if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
+         p = data + ((size_t)r * row_size);
+      else
+         p = data + ((size_t)(hdr->nrows - r - n) * row_size);
+
+      /* now read into it & byte-swap and reorder it if necessary */
+
+      nr = fread(p, row_size, n, hdr->fp);
+      if ( nr != (size_t)n )
+      {
+         *prc = GEOCON_ERR_IOERR;
+         return -1;
+      }
+
+      gc_fix_rows(hdr, p, n);
+   }
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * map binary data
+ *
+ * If the file data is in the same order and byte-order as we need in
+ * memory, we map the file and point directly into the mapping.
+ * Otherwise, we just read the data in.
+ */
+static int gc_load_data_map(
+   GEOCON_HDR    *hdr,
+   GEOCON_EXTENT *ext,
+   int           *prc)
+{
+   GEOCON_OFFSET len;
+   GEOCON_OFFSET file_len;
+
+   if ( !gc_extent_is_empty(ext)              ||
+        hdr->blocks != GEOCON_NULL            ||
+        hdr->flip                             ||
+        hdr->lat_dir != GEOCON_LAT_S_TO_N     ||
+        hdr->lon_dir != GEOCON_LON_W_TO_E )
+   {
+      return gc_load_data_bin(hdr, ext, prc);
+   }
+
+   len = hdr->points_start +
+         ((GEOCON_OFFSET)hdr->nrows * hdr->ncols *
+          (GEOCON_OFFSET)gc_point_len(hdr));
+
+   /* make sure the file is long enough for all the data */
+
+   gc_fseek(hdr->fp, 0, SEEK_END);
+   file_len = gc_ftell(hdr->fp);
+   gc_fseek(hdr->fp, hdr->points_start, SEEK_SET);
+
+   if ( file_len < len )
+   {
+      *prc = GEOCON_ERR_IOERR;
+      return -1;
+   }
+
+   /* it must also fit in our address space */
+
+   if ( len != (GEOCON_OFFSET)(size_t)len )
+   {
+      return gc_load_data_bin(hdr, ext, prc);
+   }
+
+   hdr->map_addr = gc_map_file(hdr->fp, (size_t)len);
+   if ( hdr->map_addr == GEOCON_NULL )
+   {
+      return gc_load_data_bin(hdr, ext, prc);
+   }
+
+   hdr->map_len = (size_t)len;
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+      hdr->qpoints = (void *)((char *)hdr->map_addr + hdr->points_start);
+   else
+      hdr->points  = (GEOCON_POINT *)((char *)hdr->map_addr +
+                                      hdr->points_start);
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * ascii data parsing
+ *
+ * The data section of an ascii file is mapped (or read) into memory and
+ * split into line-aligned chunks, which are parsed in parallel in two
+ * passes.  The first pass counts the lines and point lines in each chunk,
+ * which gives each chunk the line number and point index it starts at.
+ * The second pass then parses the points in each chunk directly into
+ * their places in the points array.
+ */
+#ifndef   GEOCON_ASC_CHUNK_SIZE
+#  define GEOCON_ASC_CHUNK_SIZE  (1024 * 1024)  /* min bytes per thread */
+#endif
+
+typedef struct gc_asc_chunk GEOCON_ASC_CHUNK;
+struct gc_asc_chunk
+{
+   GEOCON_HDR * hdr;
+   const char * beg;       /* start of chunk (start of a line)          */
+   const char * end;       /* end   of chunk (start of next line)       */
+   int          pass;      /* 1 = count lines, 2 = parse points         */
+   char         dec_pnt;   /* localized decimal point                   */
+
+   int          nlines;    /* pass 1: number of lines       in chunk    */
+   size_t       npts;      /* pass 1: number of point lines in chunk    */
+
+   int          line;      /* pass 2: line number before chunk          */
+   size_t       ipt;       /* pass 2: index of first point in chunk     */
+   int          rc;        /* pass 2: result code                       */
+   int          err_line;  /* pass 2: line number of error              */
+};
+
+/*------------------------------------------------------------------------
+ * get the next line in a chunk
+ *
+ * The line is copied to a buffer with any comment and all leading and
+ * trailing whitespace removed.  Returns a pointer to the next line.
+ */
+static const char * gc_asc_line(
+   const char *p,
+   const char *end,
+   char       *buf,
+   size_t      buflen,
+   char      **pline)
+{
+   const char * e = (const char *)memchr(p, '\n', (size_t)(end - p));
+   const char * next;
+   char *       c;
+   size_t       len;
+
+   if ( e == GEOCON_NULL )
+   {
+      e    = end;
+      next = end;
+   }
+   else
+   {
+      next = e + 1;
+   }
+
+   for (; p < e && isspace(*(const unsigned char *)p); p++) ;
+
+   len = (size_t)(e - p);
+   if ( len >= buflen )
+      len = buflen - 1;
+   memcpy(buf, p, len);
+   buf[len] = 0;
+
+   c = strchr(buf, '#');
+   if ( c != GEOCON_NULL )
+      *c = 0;
+
+   *pline = gc_strip(buf);
+   return next;
+}
+
+/*------------------------------------------------------------------------
+ * count the lines and point lines in a chunk
+ */
+static void gc_asc_count(
+   GEOCON_ASC_CHUNK *chunk)
+{
+   const char * p;
+   GEOCON_BOOL  blank   = TRUE;
+   GEOCON_BOOL  comment = FALSE;
+
+   chunk->nlines = 0;
+   chunk->npts   = 0;
+
+   for (p = chunk->beg; p < chunk->end; p++)
+   {
+      int c = *(const unsigned char *)p;
+
+      if ( c == '\n' )
+      {
+         chunk->nlines++;
+         if ( !blank )
+            chunk->npts++;
+         blank   = TRUE;
+         comment = FALSE;
+      }
+      else if ( c == '#' )
+      {
+         comment = TRUE;
+      }
+      else if ( !comment && !isspace(c) )
+      {
+         blank   = FALSE;
+      }
+   }
+
+   /* check for a last line with no newline */
+
+   if ( p > chunk->beg && p[-1] != '\n' )
+   {
+      chunk->nlines++;
+      if ( !blank )
+         chunk->npts++;
+   }
+}
+
+/*------------------------------------------------------------------------
+ * parse the points in a chunk
+ */
+static void gc_asc_parse(
+   GEOCON_ASC_CHUNK *chunk)
+{
+   GEOCON_HDR * hdr  = chunk->hdr;
+   const char * p    = chunk->beg;
+   size_t       npts = ((size_t)hdr->nrows * hdr->ncols);
+   size_t       ipt  = chunk->ipt;
+   int          line = chunk->line;
+   GEOCON_TOKEN tok;
+
+   chunk->rc = GEOCON_ERR_OK;
+
+   while ( p < chunk->end && ipt < npts )
+   {
+      GEOCON_POINT * pt;
+      char  buf[GEOCON_TOKENS_BUFLEN];
+      char *bufp;
+      size_t offset;
+      int   r;
+      int   c;
+
+      p = gc_asc_line(p, chunk->end, buf, sizeof(buf), &bufp);
+      line++;
+      if ( *bufp == 0 )
+         continue;
+
+      if ( gc_str_tokenize(&tok, bufp, NULL, 3) != 3 )
+      {
+         chunk->rc       = GEOCON_ERR_INVALID_TOKEN_CNT;
+         chunk->err_line = line;
+         return;
+      }
+
+      /* locate where the point is to be read into */
+
+      r = (int)(ipt / hdr->ncols);
+      c = (int)(ipt % hdr->ncols);
+
+      if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
+         offset  = ((size_t)r * hdr->ncols);
+      else
+         offset  = ((size_t)((hdr->nrows-1) - r) * hdr->ncols);
+
+      if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
+         offset += c;
+      else
+         offset += ((hdr->ncols-1) - c);
+
+      pt = hdr->points + offset;
+
+      pt->lat_value = (float)gc_atod( TOK(0), chunk->dec_pnt );
+      pt->lon_value = (float)gc_atod( TOK(1), chunk->dec_pnt );
+      pt->hgt_value = (float)gc_atod( TOK(2), chunk->dec_pnt );
+
+      ipt++;
+   }
+
+   chunk->err_line = line;
+}
+
+static void gc_asc_chunk_proc(
+   void *arg)
+{
+   GEOCON_ASC_CHUNK * chunk = (GEOCON_ASC_CHUNK *)arg;
+
+   if ( chunk->pass == 1 )
+      gc_asc_count(chunk);
+   else
+      gc_asc_parse(chunk);
+}
+
+/*------------------------------------------------------------------------
+ * load ascii data
+ */
+static int gc_load_data_asc(
+   GEOCON_HDR    *hdr,
+   GEOCON_EXTENT *ext,
+   int           *prc)
+{
+   GEOCON_ASC_CHUNK chunks[GEOCON_MAX_THREADS];
+   const char * data;
+   const char * p;
+   void *       map_addr = GEOCON_NULL;
+   char *       buf      = GEOCON_NULL;
+   GEOCON_OFFSET start;
+   GEOCON_OFFSET file_len;
+   size_t       len;
+   char         dec_pnt = gc_decimal_point();
+   int          nchunks;
+   int          line;
+   size_t       ipt;
+   int          i;
+   int          rc = 0;
+
+   GEOCON_UNUSED_PARAMETER(ext);
+
+   /* allocate memory for the point array */
+
+   hdr->points = (GEOCON_POINT *)
+                 gc_memalloc((size_t)hdr->nrows * hdr->ncols *
+                             sizeof(*hdr->points));
+   if ( hdr->points == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return -1;
+   }
+
+   /* get the data section into memory */
+
+   start = gc_ftell(hdr->fp);
+   gc_fseek(hdr->fp, 0, SEEK_END);
+   file_len = gc_ftell(hdr->fp);
+   if ( start < 0 || file_len < start ||
+        file_len != (GEOCON_OFFSET)(size_t)file_len )
+   {
+      *prc = GEOCON_ERR_IOERR;
+      return -1;
+   }
+   len = (size_t)(file_len - start);
+
+   if ( file_len > 0 )
+      map_addr = gc_map_file(hdr->fp, (size_t)file_len);
+
+   if ( map_addr != GEOCON_NULL )
+   {
+      data = (const char *)map_addr + start;
+   }
+   else
+   {
+      buf = (char *)gc_memalloc(len + 1);
+      if ( buf == GEOCON_NULL )
+      {
+         *prc = GEOCON_ERR_NO_MEMORY;
+         return -1;
+      }
+
+      gc_fseek(hdr->fp, start, SEEK_SET);
+      if ( fread(buf, 1, len, hdr->fp) != len )
+      {
+         gc_memdealloc(buf);
+         *prc = GEOCON_ERR_IOERR;
+         return -1;
+      }
+      data = buf;
+   }
+
+   /* split it into line-aligned chunks */
+
+   nchunks = gc_num_threads(len, GEOCON_ASC_CHUNK_SIZE);
+
+   p = data;
+   for (i = 0; i < nchunks; i++)
+   {
+      const char * e = data + len;
+
+      if ( i < nchunks-1 )
+      {
+         e = data + ((len / nchunks) * (i + 1));
+         if ( e < p )
+            e = p;
+         e = (const char *)memchr(e, '\n', (size_t)((data + len) - e));
+         e = (e == GEOCON_NULL) ? (data + len) : (e + 1);
+      }
+
+      memset(&chunks[i], 0, sizeof(chunks[i]));
+      chunks[i].hdr  = hdr;
+      chunks[i].beg  = p;
+      chunks[i].end  = e;
+      chunks[i].pass    = 1;
+      chunks[i].dec_pnt = dec_pnt;
+      p = e;
+   }
+
+   /* count the lines, then parse the points */
+
+   gc_run_parallel(gc_asc_chunk_proc, chunks, sizeof(chunks[0]), nchunks);
+
+   line = hdr->line_count;
+   ipt  = 0;
+   for (i = 0; i < nchunks; i++)
+   {
+      chunks[i].line = line;
+      chunks[i].ipt  = ipt;
+      chunks[i].pass = 2;
+      line += chunks[i].nlines;
+      ipt  += chunks[i].npts;
+   }
+
+   gc_run_parallel(gc_asc_chunk_proc, chunks, sizeof(chunks[0]), nchunks);
+
+   /* Report the first error (if any) and where it happened.
+      Otherwise, the line count is the line of the last point.
+   */
+   for (i = 0; i < nchunks; i++)
+   {
+      if ( chunks[i].rc != GEOCON_ERR_OK )
+      {
+         hdr->line_count = chunks[i].err_line;
+         *prc = chunks[i].rc;
+         rc = -1;
+         break;
+      }
+
+      if ( chunks[i].ipt < ((size_t)hdr->nrows * hdr->ncols) )
+         hdr->line_count = chunks[i].err_line;
+   }
+
+   if ( rc == 0 && ipt < ((size_t)hdr->nrows * hdr->ncols) )
+   {
+      hdr->line_count = line;
+      *prc = GEOCON_ERR_UNEXPECTED_EOF;
+      rc = -1;
+   }
+
+   if ( map_addr != GEOCON_NULL )
+      gc_unmap_file(map_addr, (size_t)file_len);
+   else
+      gc_memdealloc(buf);
+
+   return rc;
+}
+
+/*------------------------------------------------------------------------
+ * load data
+ */
+static int gc_load_data(
+   GEOCON_HDR    *hdr,
+   GEOCON_EXTENT *ext,
+   int            load_data,
+   int           *prc)
+{
+   if ( hdr->filetype == GEOCON_FILE_TYPE_BIN )
+   {
+      if ( load_data == GEOCON_LOAD_MAPPED )
+         return gc_load_data_map(hdr, ext, prc);
+      else
+         return gc_load_data_bin(hdr, ext, prc);
+   }
+   else
+   {
+      return gc_load_data_asc(hdr, ext, prc);
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+/* internal write routines                                                    */
+/* -------------------------------------------------------------------------- */
+
+#ifndef   GEOCON_WRITE_BLOCK_SIZE
+#  define GEOCON_WRITE_BLOCK_SIZE  (1024 * 1024)  /* bytes per write */
+#endif
+
+/*------------------------------------------------------------------------
+ * get the file records of a row of points to write
+ *
+ * "offset" is the offset of the first point of the row in memory, and
+ * the points are put in the reverse order if "reversed" is set.
+ *
+ * If the points are already in memory as "quant" says (floats if null),
+ * the records are just copied.
+ */
+static void gc_put_row(
+   const GEOCON_HDR   *hdr,
+   const GEOCON_QUANT *quant,
+   size_t              offset,
+   GEOCON_BOOL         reversed,
+   unsigned char      *rec,
+   size_t              len)
+{
+   const unsigned char * src = GEOCON_NULL;
+   int ncols = hdr->ncols;
+   int c;
+
+   if ( quant == &hdr->quant && hdr->qpoints != GEOCON_NULL )
+      src = (const unsigned char *)hdr->qpoints + (offset * len);
+   else
+   if ( quant == GEOCON_NULL && hdr->points != GEOCON_NULL )
+      src = (const unsigned char *)(hdr->points + offset);
+
+   if ( src != GEOCON_NULL )
+   {
+      if ( !reversed )
+      {
+         memcpy(rec, src, ncols * len);
+      }
+      else
+      {
+         for (c = 0; c < ncols; c++)
+            memcpy(rec + (c * len), src + ((ncols - 1 - c) * len), len);
+      }
+      return;
+   }
+
+   for (c = 0; c < ncols; c++)
+   {
+      GEOCON_POINT pt;
+
+      gc_get_point(hdr, offset + (reversed ? (ncols - 1 - c) : c), &pt);
+
+      if ( quant != GEOCON_NULL )
+         gc_encode_point(quant, &pt, rec + (c * len));
+      else
+         memcpy(rec + (c * len), &pt, len);
+   }
+}
+
+/*------------------------------------------------------------------------
+ * write a binary file
+ *
+ * If "quant" is not null, the points are quantized as it says.
+ *
+ * "flags" may include GEOCON_DATA_PACKED and/or GEOCON_DATA_TILED, in
+ * which case the points are written as blocks (compressed if packed) of
+ * "tile_size" square tiles if tiled, or else of whole rows.  The blocks
+ * are followed by their offsets, which are written first as zeros and
+ * filled in at the end.
+ *
+ * Otherwise, the points are written as bands of rows of up to
+ * GEOCON_WRITE_BLOCK_SIZE bytes in each write.
+ */
+static int gc_write_bin(
+   const GEOCON_HDR   *hdr,
+   const char         *pathname,
+   int                 byte_order,
+   const GEOCON_QUANT *quant,
+   int                 flags,
+   int                 tile_size,
+   int                *prc)
+{
+   GEOCON_OFFSET *  offsets     = GEOCON_NULL;
+   GEOCON_OFFSET    index_start = 0;
+   GEOCON_BOOL swap_data;
+   GEOCON_BOOL blocked = (flags != 0);
+   size_t len = sizeof(GEOCON_POINT);
+   size_t row_len;
+   int    block_rows = 1;
+   int    band_rows;
+   int    block_cols = hdr->ncols;
+   int    nbcols     = 1;
+   int    nblocks    = 0;
+   int    rc  = 0;
+   FILE *fp;
+
+   swap_data = hdr->flip;
+   switch (byte_order)
+   {
+      case GEOCON_ENDIAN_BIG:    swap_data ^= !gc_is_big_endian(); break;
+      case GEOCON_ENDIAN_LITTLE: swap_data ^= !gc_is_ltl_endian(); break;
+      case GEOCON_ENDIAN_NATIVE: swap_data  = FALSE;               break;
+   }
+
+   if ( quant != GEOCON_NULL )
+      len = (size_t)(quant->size[0] + quant->size[1] + quant->size[2]);
+   row_len = hdr->ncols * len;
+
+   if ( blocked )
+   {
+      if ( hdr->nrows <= 0 || hdr->ncols <= 0 )
+      {
+         *prc = GEOCON_ERR_NO_DATA;
+         return -1;
+      }
+
+      if ( (flags & GEOCON_DATA_TILED) != 0 )
+      {
+         block_rows = GEOCON_MIN(tile_size, hdr->nrows);
+         block_cols = GEOCON_MIN(tile_size, hdr->ncols);
+      }
+      else
+      if ( row_len < GEOCON_PACK_BLOCK_SIZE )
+      {
+         block_rows = (int)(GEOCON_PACK_BLOCK_SIZE / row_len);
+      }
+
+      nbcols  = (hdr->ncols + block_cols - 1) / block_cols;
+      nblocks = ((hdr->nrows + block_rows - 1) / block_rows) * nbcols;
+
+      offsets = (GEOCON_OFFSET *)
+                gc_memalloc((nblocks + 1) * sizeof(*offsets));
+      if ( offsets == GEOCON_NULL )
+      {
+         *prc = GEOCON_ERR_NO_MEMORY;
+         return -1;
+      }
+      memset(offsets, 0, (nblocks + 1) * sizeof(*offsets));
+      band_rows = block_rows;
+   }
+   else
+   {
+      band_rows = 1;
+      if ( row_len > 0 && row_len < GEOCON_WRITE_BLOCK_SIZE )
+         band_rows = (int)(GEOCON_WRITE_BLOCK_SIZE / row_len);
+      band_rows = GEOCON_MAX(1, GEOCON_MIN(band_rows, hdr->nrows));
+   }
+
+   fp = fopen(pathname, "wb");
+   if ( fp == GEOCON_NULL )
+   {
+      gc_memdealloc(offsets);
+      *prc = GEOCON_ERR_CANNOT_OPEN_FILE;
+      return -1;
+   }
+
+   /* write file header */
+   {
+      GEOCON_FILE_HDR fhdr;
+
+      memcpy(&fhdr, &hdr->fhdr, sizeof(fhdr));
+
+      fhdr.data_fmt   = (quant == GEOCON_NULL) ? GEOCON_DATA_FLOAT :
+                                                 GEOCON_DATA_QUANT ;
+      fhdr.data_fmt  |= flags;
+      fhdr.version    = (fhdr.data_fmt == GEOCON_DATA_FLOAT) ?
+                                          GEOCON_HDR_VERSION :
+                                          GEOCON_HDR_VERSION_2 ;
+      fhdr.lat_dir    = hdr->lat_dir;
+      fhdr.lon_dir    = hdr->lon_dir;
+      fhdr.nrows      = hdr->nrows;
+      fhdr.ncols      = hdr->ncols;
+      fhdr.lat_south  = hdr->lat_min;
+      fhdr.lat_north  = hdr->lat_max;
+      fhdr.lon_west   = hdr->lon_min;
+      fhdr.lon_east   = hdr->lon_max;
+
+      if ( swap_data )
+      {
+         gc_flip_hdr(&fhdr);
+      }
+      fwrite(&fhdr, sizeof(fhdr), 1, fp);
+   }
+
+   /* write quantization info */
+
+   if ( quant != GEOCON_NULL )
+   {
+      GEOCON_QUANT q = *quant;
+
+      if ( swap_data )
+      {
+         gc_flip_quant(&q);
+      }
+      fwrite(&q, sizeof(q), 1, fp);
+   }
+
+   /* write block index or tile directory & room for the offsets */
+
+   if ( (flags & GEOCON_DATA_TILED) != 0 )
+   {
+      GEOCON_TILE_HDR t;
+
+      memset(&t, 0, sizeof(t));
+      t.tile_rows = block_rows;
+      t.tile_cols = block_cols;
+      t.ntiles    = nblocks;
+
+      if ( swap_data )
+      {
+         gc_swap_int(&t.tile_rows, 1);
+         gc_swap_int(&t.tile_cols, 1);
+         gc_swap_int(&t.ntiles,    1);
+      }
+      fwrite(&t, sizeof(t), 1, fp);
+   }
+   else
+   if ( blocked )
+   {
+      GEOCON_BLOCK_HDR b;
+
+      b.block_rows = block_rows;
+      b.nblocks    = nblocks;
+
+      if ( swap_data )
+      {
+         gc_swap_int(&b.block_rows, 1);
+         gc_swap_int(&b.nblocks,    1);
+      }
+      fwrite(&b, sizeof(b), 1, fp);
+   }
+
+   if ( blocked )
+   {
+      index_start = gc_ftell(fp);
+      fwrite(offsets, sizeof(*offsets), nblocks + 1, fp);
+   }
+
+   /* write data points, a band of rows (or of blocks) at a time */
+   {
+      size_t blen  = (size_t)block_rows * block_cols * len;
+      unsigned char * rows;
+      unsigned char * tbuf = GEOCON_NULL;
+      unsigned char * sbuf = GEOCON_NULL;
+      unsigned char * cbuf = GEOCON_NULL;
+      int r;
+
+      rows = (unsigned char *)gc_memalloc(band_rows * row_len);
+      if ( blocked )
+      {
+         tbuf = (unsigned char *)gc_memalloc(blen);
+         sbuf = (unsigned char *)gc_memalloc(blen);
+         cbuf = (unsigned char *)gc_memalloc(gc_lz_bound(blen));
+      }
+
+      if ( rows == GEOCON_NULL ||
+           (blocked && (tbuf == GEOCON_NULL ||
+                        sbuf == GEOCON_NULL || cbuf == GEOCON_NULL)) )
+      {
+         gc_memdealloc(cbuf);
+         gc_memdealloc(sbuf);
+         gc_memdealloc(tbuf);
+         gc_memdealloc(rows);
+         gc_memdealloc(offsets);
+         fclose(fp);
+         *prc = GEOCON_ERR_NO_MEMORY;
+         return -1;
+      }
+
+      for (r = 0; r < hdr->nrows; r++)
+      {
+         unsigned char * row = rows + ((r % band_rows) * row_len);
+         size_t offset;
+         int nr;
+         int b;
+
+         /* get location of the next row to write */
+
+         if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
+            offset = ((size_t)r * hdr->ncols);
+         else
+            offset = ((size_t)((hdr->nrows-1) - r) * hdr->ncols);
+
+         gc_put_row(hdr, quant, offset,
+                    hdr->lon_dir != GEOCON_LON_W_TO_E, row, len);
+
+         if ( (r % band_rows) != band_rows - 1 && r != hdr->nrows - 1 )
+            continue;
+
+         nr = (r % band_rows) + 1;
+
+         if ( swap_data )
+         {
+            if ( quant != GEOCON_NULL )
+               gc_flip_qpoints(quant, rows, (size_t)nr * hdr->ncols);
+            else
+               gc_flip_points((GEOCON_POINT *)rows, nr * hdr->ncols);
+         }
+
+         if ( !blocked )
+         {
+            if ( fwrite(rows, row_len, nr, fp) != (size_t)nr )
+            {
+               *prc = GEOCON_ERR_IOERR;
+               rc = -1;
+               break;
+            }
+            continue;
+         }
+
+         /* write out the band of blocks these rows make up */
+
+         for (b = 0; b < nbcols; b++)
+         {
+            int    c0 = b * block_cols;
+            int    nc = GEOCON_MIN(block_cols, hdr->ncols - c0);
+            size_t npts = (size_t)nr * nc;
+            int    i;
+
+            for (i = 0; i < nr; i++)
+            {
+               memcpy(tbuf + ((size_t)i * nc * len),
+                      rows + ((size_t)i * row_len) + (c0 * len), nc * len);
+            }
+
+            offsets[((r / block_rows) * nbcols) + b] = gc_ftell(fp);
+
+            if ( (flags & GEOCON_DATA_PACKED) != 0 )
+            {
+               size_t clen;
+
+               gc_pack_shuffle(tbuf, sbuf, npts, len);
+               clen = gc_lz_compress(sbuf, npts * len, cbuf);
+               if ( fwrite(cbuf, 1, clen, fp) != clen )
+                  rc = -1;
+            }
+            else
+            {
+               if ( fwrite(tbuf, len, npts, fp) != npts )
+                  rc = -1;
+            }
+         }
+
+         if ( rc != 0 )
+         {
+            *prc = GEOCON_ERR_IOERR;
+            break;
+         }
+      }
+
+      gc_memdealloc(cbuf);
+      gc_memdealloc(sbuf);
+      gc_memdealloc(tbuf);
+      gc_memdealloc(rows);
+   }
+
+   /* go back & fill in the block offsets */
+
+   if ( blocked && rc == 0 )
+   {
+      offsets[nblocks] = gc_ftell(fp);
+
+      if ( swap_data )
+         gc_swap_off(offsets, nblocks + 1);
+
+      if ( gc_fseek(fp, index_start, SEEK_SET) != 0 ||
+           fwrite(offsets, sizeof(*offsets), nblocks + 1, fp) !=
+              (size_t)(nblocks + 1) )
+      {
+         *prc = GEOCON_ERR_IOERR;
+         rc = -1;
+      }
+   }
+
+   gc_memdealloc(offsets);
+
+   if ( fclose(fp) != 0 && rc == 0 )
+   {
+      *prc = GEOCON_ERR_IOERR;
+      rc = -1;
+   }
+
+   return rc;
+}
+
+/*------------------------------------------------------------------------
+ * format a band of rows of an ascii file
+ *
+ * Each row is a blank line followed by a line for each point, and each
+ * point takes at most GEOCON_ASC_POINT_LEN characters.
+ */
+#define GEOCON_ASC_POINT_LEN  ((3 * 64) + 3)
+
+typedef struct gc_asc_band GEOCON_ASC_BAND;
+struct gc_asc_band
+{
+   const GEOCON_HDR * hdr;
+   int                beg;       /* first row of band                  */
+   int                end;       /* last  row of band + 1              */
+   char *             buf;       /* formatted rows                     */
+   size_t             len;       /* length of formatted rows           */
+};
+
+static void gc_asc_band_proc(
+   void *arg)
+{
+   GEOCON_ASC_BAND *  band = (GEOCON_ASC_BAND *)arg;
+   const GEOCON_HDR * hdr  = band->hdr;
+   char *             p    = band->buf;
+   int r;
+   int c;
+
+   for (r = band->beg; r < band->end; r++)
+   {
+      size_t offset;
+
+      /* get location of the next row to write */
+
+      if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
+         offset = ((size_t)r * hdr->ncols);
+      else
+         offset = ((size_t)((hdr->nrows-1) - r) * hdr->ncols);
+
+      *p++ = '\n';
+      for (c = 0; c < hdr->ncols; c++)
+      {
+         GEOCON_POINT pt;
+
+         if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
+            gc_get_point(hdr, offset + c, &pt);
+         else
+            gc_get_point(hdr, offset + ((hdr->ncols-1) - c), &pt);
+
+         p += gc_ftoa(p, pt.lat_value);   *p++ = ' ';
+         p += gc_ftoa(p, pt.lon_value);   *p++ = ' ';
+         p += gc_ftoa(p, pt.hgt_value);   *p++ = '\n';
+      }
+   }
+
+   band->len = (size_t)(p - band->buf);
+}
+
+/*------------------------------------------------------------------------
+ * write an ascii file
+ */
+static int gc_write_asc(
+   const GEOCON_HDR *hdr,
+   const char       *pathname,
+   int              *prc)
+{
+   FILE *fp;
+   int   rc = 0;
+
+   fp = fopen(pathname, "w");
+   if ( fp == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_CANNOT_OPEN_FILE;
+      return -1;
+   }
+
+   /* write file header */
+   {
+      const GEOCON_FILE_HDR * fhdr = &hdr->fhdr;
+
+      fprintf(fp, "info             \"%s\"\n", fhdr->info            );
+      fprintf(fp, "source           \"%s\"\n", fhdr->source          );
+      fprintf(fp, "date             \"%s\"\n", fhdr->date            );
+      fprintf(fp, "\n");
+
+      fprintf(fp, "lat_dir          %s\n",  hdr->lat_dir == GEOCON_LAT_S_TO_N ?
+                                            "S-N" : "N-S"            );
+      fprintf(fp, "lon_dir          %s\n",  hdr->lon_dir == GEOCON_LON_E_TO_W ?
+                                            "E-W" : "W-E"            );
+
+      fprintf(fp, "nrows            %d\n",      hdr->nrows           );
+      fprintf(fp, "ncols            %d\n",      hdr->ncols           );
+      fprintf(fp, "\n");
+
+      fprintf(fp, "lat_south        %.17g\n",   hdr->lat_min         );
+      fprintf(fp, "lat_north        %.17g\n",   hdr->lat_max         );
+
+      fprintf(fp, "lon_west         %.17g\n",   hdr->lon_min         );
+      fprintf(fp, "lon_east         %.17g\n",   hdr->lon_max         );
+
+      fprintf(fp, "lat_delta        %.17g\n",  fhdr->lat_delta       );
+      fprintf(fp, "lon_delta        %.17g\n",  fhdr->lon_delta       );
+      fprintf(fp, "\n");
+
+      fprintf(fp, "horz_scale       %.17g\n",  fhdr->horz_scale      );
+      fprintf(fp, "vert_scale       %.17g\n",  fhdr->vert_scale      );
+      fprintf(fp, "\n");
+
+      fprintf(fp, "from_gcs         \"%s\"\n", fhdr->from_gcs        );
+      fprintf(fp, "from_vcs         \"%s\"\n", fhdr->from_vcs        );
+      fprintf(fp, "from_semi_major  %.17g\n",  fhdr->from_semi_major );
+      fprintf(fp, "from_flattening  %.17g\n",  fhdr->from_flattening );
+      fprintf(fp, "\n");
+
+      fprintf(fp, "to_gcs           \"%s\"\n", fhdr->to_gcs          );
+      fprintf(fp, "to_vcs           \"%s\"\n", fhdr->to_vcs          );
+      fprintf(fp, "to_semi_major    %.17g\n",  fhdr->to_semi_major   );
+      fprintf(fp, "to_flattening    %.17g\n",  fhdr->to_flattening   );
+   }
+
+   /* write data points, formatting bands of rows in parallel */
+   {
+      GEOCON_ASC_BAND bands[GEOCON_MAX_THREADS];
+      size_t row_len = 1 + ((size_t)hdr->ncols * GEOCON_ASC_POINT_LEN);
+      int    band_rows;
+      int    nbands;
+      int    r;
+      int    i;
+
+      band_rows = (int)(GEOCON_WRITE_BLOCK_SIZE / row_len);
+      band_rows = GEOCON_MAX(1, GEOCON_MIN(band_rows, hdr->nrows));
+
+      nbands = gc_num_threads((size_t)hdr->nrows * row_len,
+                              GEOCON_WRITE_BLOCK_SIZE);
+
+      for (i = 0; i < nbands; i++)
+      {
+         bands[i].hdr = hdr;
+         bands[i].buf = (char *)gc_memalloc(band_rows * row_len);
+         if ( bands[i].buf == GEOCON_NULL )
+         {
+            *prc = GEOCON_ERR_NO_MEMORY;
+            rc = -1;
+            nbands = i;
+            break;
+         }
+      }
+
+      for (r = 0; rc == 0 && r < hdr->nrows; )
+      {
+         int n;
+
+         for (n = 0; n < nbands && r < hdr->nrows; n++)
+         {
+            bands[n].beg = r;
+            bands[n].end = GEOCON_MIN(r + band_rows, hdr->nrows);
+            r = bands[n].end;
+         }
+
+         gc_run_parallel(gc_asc_band_proc, bands, sizeof(bands[0]), n);
+
+         for (i = 0; i < n; i++)
+         {
+            if ( fwrite(bands[i].buf, 1, bands[i].len, fp) != bands[i].len )
+            {
+               *prc = GEOCON_ERR_IOERR;
+               rc = -1;
+               break;
+            }
+         }
+      }
+
+      for (i = 0; i < nbands; i++)
+         gc_memdealloc(bands[i].buf);
+   }
+
+   if ( fclose(fp) != 0 && rc == 0 )
+   {
+      *prc = GEOCON_ERR_IOERR;
+      rc = -1;
+   }
+
+   return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* internal on-the-fly read routines                                          */
+/* -------------------------------------------------------------------------- */
+
+/*------------------------------------------------------------------------
+ * read a span of points in a row from the file
+ *
+ * The span is given in memory order (SW to NE), and is contiguous in the
+ * file, so it is read with one positional read, and then byte-swapped,
+ * decoded, and reordered as needed.  Since a positional read does not use
+ * the position of the stream, no lock is needed unless the OS can't do one.
+ * If the file is packed or tiled, the span is copied from its blocks.
+ */
+static int gc_read_span(
+   const GEOCON_HDR * hdr,
+   GEOCON_POINT       pts[],
+   int                irow,
+   int                icol,
+   int                n)
+{
+   size_t len = gc_point_len(hdr);
+   GEOCON_OFFSET offset;
+   int  rc;
+
+   /* get the index in the file of the span to be read */
+
+   if ( hdr->lat_dir == GEOCON_LAT_S_TO_N )
+      offset  = ((GEOCON_OFFSET)irow * hdr->ncols);
+   else
+      offset  = ((GEOCON_OFFSET)((hdr->nrows-1) - irow) * hdr->ncols);
+
+   if ( hdr->lon_dir == GEOCON_LON_W_TO_E )
+      offset += icol;
+   else
+      offset += (hdr->ncols - (icol + n));
+
+   /* do the read */
+
+   if ( hdr->blocks != GEOCON_NULL )
+   {
+      int frow = (int)(offset / hdr->ncols);
+      int fcol = (int)(offset % hdr->ncols);
+
+      rc = gc_blocks_read(hdr, pts, frow, fcol, 1, n);
+   }
+   else
+   {
+      offset = hdr->points_start + (offset * (GEOCON_OFFSET)len);
+
+#ifdef GEOCON_READ_AT_NEEDS_LOCK
+      gc_mutex_enter(hdr->mutex);
+#endif
+      rc = gc_read_at(hdr->fp, pts, n * len, offset);
+#ifdef GEOCON_READ_AT_NEEDS_LOCK
+      gc_mutex_leave(hdr->mutex);
+#endif
+   }
+
+   if ( rc != 0 )
+      return rc;
+
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+   {
+      if ( hdr->flip )
+         gc_flip_qpoints(&hdr->quant, pts, n);
+      gc_decode_points(hdr, pts, n);
+   }
+   else
+   if ( hdr->flip )
+   {
+      gc_flip_points(pts, n);
+   }
+
+   if ( hdr->lon_dir != GEOCON_LON_W_TO_E )
+      gc_reverse_row(pts, n);
+
+   return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* internal tile cache routines                                               */
+/* -------------------------------------------------------------------------- */
+
+/*------------------------------------------------------------------------
+ * tile cache
+ *
+ * When reading data on-the-fly, the grid may be cached in tiles of
+ * GEOCON_TILE_ROWS x GEOCON_TILE_COLS points, which are stored in memory
+ * order (SW to NE).  The tiles are spread across a number of shards, each
+ * with its own mutex, its own share of the memory budget, and its own
+ * LRU list of tiles.  Successive tiles are in different shards, so that
+ * threads working in different places rarely want the same shard.
+ *
+ * A shard's mutex is not held while reading a tile from the file.  If two
+ * threads read the same tile at once, the second one to finish just
+ * discards its copy.
+ */
+#ifndef   GEOCON_TILE_ROWS
+#  define GEOCON_TILE_ROWS    32   /* rows in a tile */
+#endif
+
+#ifndef   GEOCON_TILE_COLS
+#  define GEOCON_TILE_COLS    32   /* cols in a tile */
+#endif
+
+#ifndef   GEOCON_TILE_SHARDS
+#  define GEOCON_TILE_SHARDS  16   /* max shards in a cache */
+#endif
+
+#ifndef   GEOCON_TILE_PAYBACK
+#  define GEOCON_TILE_PAYBACK  8   /* hits per miss to keep reading tiles */
+#endif
+
+#ifndef   GEOCON_TILE_PROBE
+#  define GEOCON_TILE_PROBE  256   /* misses per tile read regardless */
+#endif
+
+#define GEOCON_TILE_POINTS   (GEOCON_TILE_ROWS * GEOCON_TILE_COLS)
+#define GEOCON_TILE_DECAY    4096  /* halve the hit & miss counts past */
+
+typedef struct geocon_tile GEOCON_TILE;
+struct geocon_tile
+{
+   GEOCON_TILE *  prev;             /* next more-recently used tile     */
+   GEOCON_TILE *  next;             /* next less-recently used tile     */
+   int            index;            /* index of tile in grid            */
+   GEOCON_POINT   points[GEOCON_TILE_POINTS];
+};
+
+typedef struct geocon_shard GEOCON_SHARD;
+struct geocon_shard
+{
+   void *         mutex;            /* MUTEX for this shard             */
+   GEOCON_TILE *  head;             /* most-recently  used tile         */
+   GEOCON_TILE *  tail;             /* least-recently used tile         */
+   int            ntiles;           /* number of tiles in this shard    */
+   int            max_tiles;        /* max    tiles in this shard       */
+   unsigned long  hits;             /* recent tiles  found              */
+   unsigned long  misses;           /* recent tiles  not found          */
+};
+
+typedef struct geocon_cache GEOCON_CACHE;
+struct geocon_cache
+{
+   int            tile_rows;        /* number of tile rows in grid      */
+   int            tile_cols;        /* number of tile cols in grid      */
+   GEOCON_TILE ** tiles;            /* all tiles in grid (null if not
+                                       cached), each of which is owned
+                                       by the shard for its index       */
+   int            nshards;          /* number of shards                 */
+   GEOCON_SHARD   shards[GEOCON_TILE_SHARDS];
+};
+
+static void gc_cache_delete(
+   GEOCON_CACHE *cache)
+{
+   int i;
+
+   for (i = 0; i < cache->nshards; i++)
+   {
+      GEOCON_SHARD * shard = &cache->shards[i];
+      GEOCON_TILE  * t;
+
+      while ( (t = shard->head) != GEOCON_NULL )
+      {
+         shard->head = t->next;
+         gc_memdealloc(t);
+      }
+
+      if ( shard->mutex != GEOCON_NULL )
+         gc_mutex_delete(shard->mutex);
+   }
+
+   if ( cache->tiles != GEOCON_NULL )
+      gc_memdealloc(cache->tiles);
+
+   gc_memdealloc(cache);
+}
+
+static GEOCON_CACHE * gc_cache_create(
+   const GEOCON_HDR *hdr,
+   size_t            max_bytes)
+{
+   GEOCON_CACHE * cache;
+   size_t max_tiles = max_bytes / sizeof(GEOCON_TILE);
+   size_t ntiles;
+   int i;
+
+   cache = (GEOCON_CACHE *)gc_memalloc(sizeof(*cache));
+   if ( cache == GEOCON_NULL )
+      return GEOCON_NULL;
+   memset(cache, 0, sizeof(*cache));
+
+   cache->tile_rows = (hdr->nrows + GEOCON_TILE_ROWS - 1) / GEOCON_TILE_ROWS;
+   cache->tile_cols = (hdr->ncols + GEOCON_TILE_COLS - 1) / GEOCON_TILE_COLS;
+   ntiles = (size_t)cache->tile_rows * cache->tile_cols;
+
+   /* There is no point in having room for more tiles than the grid has,
+      and each shard gets at least one tile.
+   */
+   if ( max_tiles > ntiles )
+      max_tiles = ntiles;
+   if ( max_tiles < 1 )
+      max_tiles = 1;
+
+   cache->nshards = (int)GEOCON_MIN(max_tiles, GEOCON_TILE_SHARDS);
+
+   cache->tiles = (GEOCON_TILE **)gc_memalloc(ntiles * sizeof(*cache->tiles));
+   if ( cache->tiles == GEOCON_NULL )
+   {
+      gc_cache_delete(cache);
+      return GEOCON_NULL;
+   }
+   memset(cache->tiles, 0, ntiles * sizeof(*cache->tiles));
+
+   /* Shard i owns the tiles whose index is i modulo the number of shards,
+      so it never needs room for more than that.  The room is shared out
+      to match, so a budget that covers the grid holds every tile.
+   */
+   for (i = 0; i < cache->nshards; i++)
+   {
+      GEOCON_SHARD * shard = &cache->shards[i];
+      size_t owned = (ntiles    / cache->nshards) +
+                     ((size_t)i < (ntiles    % cache->nshards));
+      size_t room  = (max_tiles / cache->nshards) +
+                     ((size_t)i < (max_tiles % cache->nshards));
+
+      shard->max_tiles = (int)GEOCON_MIN(owned, room);
+      shard->mutex     = gc_mutex_create();
+      if ( shard->mutex == GEOCON_NULL )
+      {
+         gc_cache_delete(cache);
+         return GEOCON_NULL;
+      }
+   }
+
+   return cache;
+}
+
+/*------------------------------------------------------------------------
+ * read a tile from the file
+ *
+ * The part of each row in the tile is read with one read.  Any part of
+ * the tile past the edge of the grid is left unread.
+ */
+static int gc_cache_read_tile(
+   const GEOCON_HDR *hdr,
+   const GEOCON_CACHE *cache,
+   GEOCON_TILE      *t)
+{
+   int row0  = (t->index / cache->tile_cols) * GEOCON_TILE_ROWS;
+   int col0  = (t->index % cache->tile_cols) * GEOCON_TILE_COLS;
+   int nrows = GEOCON_MIN(GEOCON_TILE_ROWS, hdr->nrows - row0);
+   int ncols = GEOCON_MIN(GEOCON_TILE_COLS, hdr->ncols - col0);
+   int r;
+
+   for (r = 0; r < nrows; r++)
+   {
+      GEOCON_POINT * p = t->points + (r * GEOCON_TILE_COLS);
+
+      if ( gc_read_span(hdr, p, row0 + r, col0, ncols) != 0 )
+         return -1;
+   }
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * unlink a tile from its shard's LRU list
+ */
+static void gc_cache_unlink(
+   GEOCON_SHARD  *shard,
+   GEOCON_TILE   *t)
+{
+   if ( t->prev != GEOCON_NULL ) t->prev->next = t->next;
+   else                          shard->head   = t->next;
+
+   if ( t->next != GEOCON_NULL ) t->next->prev = t->prev;
+   else                          shard->tail   = t->prev;
+}
+
+/*------------------------------------------------------------------------
+ * link a tile at the head of its shard's LRU list
+ */
+static void gc_cache_link(
+   GEOCON_SHARD  *shard,
+   GEOCON_TILE   *t)
+{
+   t->prev = GEOCON_NULL;
+   t->next = shard->head;
+
+   if ( shard->head != GEOCON_NULL ) shard->head->prev = t;
+   else                              shard->tail       = t;
+
+   shard->head = t;
+}
+
+/*------------------------------------------------------------------------
+ * look for a tile in its shard
+ *
+ * The shard's mutex must be held.  If the tile is there, it is made the
+ * most-recently used, and this counts as a hit.  If not, this counts as a
+ * miss, and "*load" is set to whether the tile should be read into the
+ * cache.
+ *
+ * Reading a tile costs a read for each of its rows, where a miss that
+ * isn't read into the cache costs one read.  So once the shard is full,
+ * reading tiles is only worth it if the shard's recent hits show that
+ * they are being reused.  Otherwise (as when random points are spread over a
+ * grid much bigger than the cache) the caller just reads the points it
+ * wants.  Every GEOCON_TILE_PROBE'th miss reads the tile anyway, so that
+ * the shard can tell when points become more local.
+ */
+static GEOCON_TILE * gc_cache_find(
+   GEOCON_CACHE  *cache,
+   GEOCON_SHARD  *shard,
+   int            index,
+   GEOCON_BOOL   *load)
+{
+   GEOCON_TILE * t = cache->tiles[index];
+
+   if ( t != GEOCON_NULL )
+   {
+      if ( t != shard->head )
+      {
+         gc_cache_unlink(shard, t);
+         gc_cache_link  (shard, t);
+      }
+      shard->hits++;
+   }
+   else
+   {
+      shard->misses++;
+      *load = ( shard->ntiles < shard->max_tiles                       ||
+                shard->hits  >= shard->misses * GEOCON_TILE_PAYBACK     ||
+                (shard->misses % GEOCON_TILE_PROBE) == 0 );
+   }
+
+   if ( shard->hits + shard->misses > GEOCON_TILE_DECAY )
+   {
+      shard->hits   /= 2;
+      shard->misses /= 2;
+   }
+
+   return t;
+}
+
+/*------------------------------------------------------------------------
+ * read a tile into the cache
+ *
+ * The "n" points starting at "ipt" in the tile are copied to "pts".
+ * Returns FALSE if the tile could not be read.
+ */
+static GEOCON_BOOL gc_cache_load(
+   const GEOCON_HDR *hdr,
+   GEOCON_CACHE     *cache,
+   GEOCON_SHARD     *shard,
+   int               index,
+   GEOCON_POINT      pts[],
+   int               ipt,
+   int               n)
+{
+   GEOCON_TILE  * t;
+   GEOCON_TILE  * old = GEOCON_NULL;
+
+   t = (GEOCON_TILE *)gc_memalloc(sizeof(*t));
+   if ( t == GEOCON_NULL )
+      return FALSE;
+
+   t->index = index;
+   if ( gc_cache_read_tile(hdr, cache, t) != 0 )
+   {
+      gc_memdealloc(t);
+      return FALSE;
+   }
+   memcpy(pts, t->points + ipt, n * sizeof(*pts));
+
+   /* add it, unless someone beat us to it */
+
+   gc_mutex_enter(shard->mutex);
+   {
+      if ( cache->tiles[index] == GEOCON_NULL )
+      {
+         if ( shard->ntiles >= shard->max_tiles )
+         {
+            old = shard->tail;
+            gc_cache_unlink(shard, old);
+            cache->tiles[old->index] = GEOCON_NULL;
+            shard->ntiles--;
+         }
+
+         gc_cache_link(shard, t);
+         cache->tiles[index] = t;
+         shard->ntiles++;
+         t = GEOCON_NULL;
+      }
+   }
+   gc_mutex_leave(shard->mutex);
+
+   if ( old != GEOCON_NULL )
+      gc_memdealloc(old);
+   if ( t   != GEOCON_NULL )
+      gc_memdealloc(t);
+
+   return TRUE;
+}
+
+/*------------------------------------------------------------------------
+ * get a span of "n" points in a row from the tile cache
+ *
+ * The span must be in the grid.  Returns FALSE if a tile it needs isn't
+ * in the cache and shouldn't (or couldn't) be read into it, in which case
+ * the caller should read the span from the file.
+ */
+static GEOCON_BOOL gc_cache_get(
+   const GEOCON_HDR *hdr,
+   GEOCON_POINT      pts[],
+   int               irow,
+   int               icol,
+   int               n)
+{
+   GEOCON_CACHE * cache = (GEOCON_CACHE *)hdr->cache;
+   int i;
+
+   for (i = 0; i < n; )
+   {
+      GEOCON_SHARD * shard;
+      GEOCON_TILE  * t;
+      GEOCON_BOOL    load = FALSE;
+      int index;
+      int ipt;
+      int m;
+
+      /* get the part of the span in the next tile */
+
+      index = ((irow / GEOCON_TILE_ROWS) * cache->tile_cols) +
+               ((icol + i) / GEOCON_TILE_COLS);
+      ipt   = ((irow % GEOCON_TILE_ROWS) * GEOCON_TILE_COLS) +
+               ((icol + i) % GEOCON_TILE_COLS);
+      m     = GEOCON_MIN(n - i,
+                         GEOCON_TILE_COLS - ((icol + i) % GEOCON_TILE_COLS));
+      shard = &cache->shards[index % cache->nshards];
+
+      gc_mutex_enter(shard->mutex);
+      {
+         t = gc_cache_find(cache, shard, index, &load);
+         if ( t != GEOCON_NULL )
+            memcpy(pts + i, t->points + ipt, m * sizeof(*pts));
+      }
+      gc_mutex_leave(shard->mutex);
+
+      if ( t == GEOCON_NULL )
+      {
+         if ( !load ||
+              !gc_cache_load(hdr, cache, shard, index, pts + i, ipt, m) )
+         {
+            return FALSE;
+         }
+      }
+
+      i += m;
+   }
+
+   return TRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+/* internal transformation routines                                           */
+/* -------------------------------------------------------------------------- */
+
+/*------------------------------------------------------------------------
+ * Get a lat/lon shift value (either from a file or from memory).
+ */
+static void gc_get_shift_from_file(
+   const GEOCON_HDR * hdr,
+   GEOCON_POINT *     pt,
+   int                irow,
+   int                icol)
+{
+   if ( hdr->fp == GEOCON_NULL || gc_read_span(hdr, pt, irow, icol, 1) != 0 )
+   {
+      pt->lat_value = 0.0;
+      pt->lon_value = 0.0;
+      pt->hgt_value = 0.0;
+   }
+}
+
+static void gc_get_shift_from_data(
+   const GEOCON_HDR * hdr,
+   GEOCON_POINT *     pt,
+   int                irow,
+   int                icol)
+{
+   size_t offset = ((size_t)irow * hdr->ncols) + icol;
+
+   gc_get_point(hdr, offset, pt);
+}
+
+static void gc_get_shift(
+   const GEOCON_HDR * hdr,
+   GEOCON_POINT *     pt,
+   int                irow,
+   int                icol)
+{
+   if ( irow < 0 || irow >= hdr->nrows ||
+        icol < 0 || icol >= hdr->ncols )
+   {
+      pt->lat_value = 0.0;
+      pt->lon_value = 0.0;
+      pt->hgt_value = 0.0;
+   }
+   else
+   {
+      if ( gc_data_in_memory(hdr) )
+      {
+         gc_get_shift_from_data(hdr, pt, irow, icol);
+      }
+      else
+      if ( hdr->fp     != GEOCON_NULL )
+      {
+         if ( hdr->cache == GEOCON_NULL ||
+              !gc_cache_get(hdr, pt, irow, icol, 1) )
+         {
+            gc_get_shift_from_file(hdr, pt, irow, icol);
+         }
+      }
+      else
+      {
+         pt->lat_value = 0.0;
+         pt->lon_value = 0.0;
+         pt->hgt_value = 0.0;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+ * Get "n" successive lat/lon shift values in a row.
+ *
+ * This is the same as calling gc_get_shift() for each point, except that
+ * the part of the span that is in the grid is gotten from the cache or
+ * read from a file with one read.
+ */
+static void gc_get_shift_row(
+   const GEOCON_HDR * hdr,
+   GEOCON_POINT       pts[],
+   int                irow,
+   int                icol,
+   int                n)
+{
+   int beg = GEOCON_MAX(icol,     0);
+   int end = GEOCON_MIN(icol + n, hdr->ncols);
+   int i;
+
+   if ( !gc_data_in_memory(hdr) && hdr->fp != GEOCON_NULL &&
+        beg < end && irow >= 0 && irow < hdr->nrows           &&
+        ((hdr->cache != GEOCON_NULL &&
+          gc_cache_get(hdr, pts + (beg - icol), irow, beg, end - beg)) ||
+         gc_read_span(hdr, pts + (beg - icol), irow, beg, end - beg) == 0) )
+   {
+      for (i = 0; i < n; i++)
+      {
+         if ( i < (beg - icol) || i >= (end - icol) )
+         {
+            pts[i].lat_value = 0.0;
+            pts[i].lon_value = 0.0;
+            pts[i].hgt_value = 0.0;
+         }
+      }
+   }
+   else
+   {
+      for (i = 0; i < n; i++)
+         gc_get_shift(hdr, &pts[i], irow, icol + i);
+   }
+}
+
+/*------------------------------------------------------------------------
+ * Get the lat, lon, and hgt shift values of a window of points.
+ *
+ * This gets "nr" rows of "nc" (no more than 4) values of each component,
+ * starting at (irow, icol), each row after the one before it.  If the
+ * data is in planes and the window is all in the grid, each row of each
+ * component is just copied from its plane.
+ */
+#define GEOCON_WINDOW_MAX  4   /* max rows & cols in a window */
+
+static void gc_get_window(
+   const GEOCON_HDR * hdr,
+   int                irow,
+   int                icol,
+   int                nr,
+   int                nc,
+   float              lat[],
+   float              lon[],
+   float              hgt[])
+{
+   int i;
+   int j;
+
+   if ( hdr->planes != GEOCON_NULL &&
+        irow >= 0 && irow <= hdr->nrows - nr &&
+        icol >= 0 && icol <= hdr->ncols - nc )
+   {
+      size_t npts = (size_t)hdr->nrows * hdr->ncols;
+      const float * plat = hdr->planes + ((size_t)irow * hdr->ncols) + icol;
+      const float * plon = plat + npts;
+      const float * phgt = plon + npts;
+
+      for (i = 0; i < nr; i++)
+      {
+         for (j = 0; j < nc; j++)
+         {
+            lat[j] = plat[j];
+            lon[j] = plon[j];
+            hgt[j] = phgt[j];
+         }
+
+         lat  += nc;
+         lon  += nc;
+         hgt  += nc;
+         plat += hdr->ncols;
+         plon += hdr->ncols;
+         phgt += hdr->ncols;
+      }
+   }
+   else
+   {
+      GEOCON_POINT row[GEOCON_WINDOW_MAX];
+
+      for (i = 0; i < nr; i++)
+      {
+         gc_get_shift_row(hdr, row, irow + i, icol, nc);
+
+         for (j = 0; j < nc; j++)
+         {
+            lat[j] = row[j].lat_value;
+            lon[j] = row[j].lon_value;
+            hgt[j] = row[j].hgt_value;
+         }
+
+         lat += nc;
+         lon += nc;
+         hgt += nc;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+ * calculate the shifts for a point using bilinear interpolation
+ */
+static void gc_calculate_shifts_bilinear(
+   const GEOCON_HDR * hdr,
+   double       lat_deg,
+   double       lon_deg,
+   double *     lat_shift,
+   double *     lon_shift,
+   double *     hgt_shift)
+{
+   float        lat[4], lon[4], hgt[4];
+   double       x_grid_index, y_grid_index, dx, dy;
+   double       h1,  h2,  h3,  h4;
+   double       a00, a01, a10, a11;
+   int          icol, irow;
+
+   /* get the corner points around our point */
+   {
+      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
+      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+
+      icol = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
+      irow = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
+
+      dx   = (x_grid_index - icol);
+      dy   = (y_grid_index - irow);
+
+      /* corner points around p are in this order:
+
+                        points    values
+                        -----     ---------
+                        C   D     h3     h4
+                          p           p
+         (irow,icol) -> A   B     h1     h2
+
+         and are stored in the order A B C D.
+      */
+      gc_get_window(hdr, irow, icol, 2, 2, lat, lon, hgt);
+   }
+
+   /* Longitude */
+   {
+      h1 = lon[0];
+      h2 = lon[1];
+      h3 = lon[2];
+      h4 = lon[3];
+
+      a00 =  h1;
+      a10 = (h2 - h1);
+      a01 = (h3 - h1);
+      a11 = (h1 - h2) - (h3 - h4);
+
+      *lon_shift = a00 + (a10 * dx) + (a01 * dy) + (a11 * dx * dy);
+   }
+
+   /* Latitude */
+   {
+      h1 = lat[0];
+      h2 = lat[1];
+      h3 = lat[2];
+      h4 = lat[3];
+
+      a00 =  h1;
+      a10 = (h2 - h1);
+      a01 = (h3 - h1);
+      a11 = (h1 - h2) - (h3 - h4);
+
+      *lat_shift = a00 + (a10 * dx) + (a01 * dy) + (a11 * dx * dy);
+   }
+
+   /* Height */
+   {
+      h1 = hgt[0];
+      h2 = hgt[1];
+      h3 = hgt[2];
+      h4 = hgt[3];
+
+      a00 =  h1;
+      a10 = (h2 - h1);
+      a01 = (h3 - h1);
+      a11 = (h1 - h2) - (h3 - h4);
+
+      *hgt_shift = a00 + (a10 * dx) + (a01 * dy) + (a11 * dx * dy);
+   }
+}
+
+/*------------------------------------------------------------------------
+ * bicubic coefficients
+ *
+ * The bicubic polynomial of a cell is worked out just as in
+ * gc_calculate_shifts_bicubic(): a cubic in dy through each column of
+ * the 4x4 points, then a cubic in dx through those.  Since each cubic's
+ * coefficients are linear in its values, this gives 16 coefficients,
+ * k[p][q], of (dx^p * dy^q), which are stored in that order for the lat,
+ * lon, and hgt values of each cell, in rows of (ncols + 2) cells,
+ * starting at the phantom cell at (-1, -1).
+ */
+#define GEOCON_COEFS_PER_CELL  48
+
+/*------------------------------------------------------------------------
+ * get the coefficients of the cubic through 4 values at -1, 0, 1, & 2
+ */
+static void gc_coefs_cubic(
+   double v0,
+   double v1,
+   double v2,
+   double v3,
+   double a[4])
+{
+   double d0 = v0 - v1;
+   double d2 = v2 - v1;
+   double d3 = v3 - v1;
+
+   a[0] = v1;
+   a[1] = d2 - (d0/3.0 + d3/6.0);
+   a[2] = (d0 + d2)/2.0;
+   a[3] = (d3 - d0)/6.0 - d2/2.0;
+}
+
+/*------------------------------------------------------------------------
+ * get the coefficients of one component of a cell from its 4x4 values
+ */
+static void gc_coefs_cell(
+   const float h[16],
+   double      k[16])
+{
+   double col[4][4];
+   int    p;
+   int    q;
+   int    j;
+
+   for (j = 0; j < 4; j++)
+      gc_coefs_cubic(h[j], h[4 + j], h[8 + j], h[12 + j], col[j]);
+
+   for (q = 0; q < 4; q++)
+   {
+      double a[4];
+
+      gc_coefs_cubic(col[0][q], col[1][q], col[2][q], col[3][q], a);
+      for (p = 0; p < 4; p++)
+         k[(p * 4) + q] = a[p];
+   }
+}
+
+/*------------------------------------------------------------------------
+ * evaluate one component of a cell's polynomial
+ */
+static double gc_coefs_eval(
+   const double k[16],
+   double       dx,
+   double       dy)
+{
+   double r[4];
+   int    p;
+
+   for (p = 0; p < 4; p++)
+   {
+      const double * kp = k + (p * 4);
+
+      r[p] = kp[0] + dy * (kp[1] + dy * (kp[2] + dy * kp[3]));
+   }
+
+   return r[0] + dx * (r[1] + dx * (r[2] + dx * r[3]));
+}
+
+/*------------------------------------------------------------------------
+ * build the coefficients of a range of rows of cells
+ */
+typedef struct geocon_coefs_task GEOCON_COEFS_TASK;
+struct geocon_coefs_task
+{
+   const GEOCON_HDR * hdr;           /* object                           */
+   double *           coefs;         /* coefficients of all cells        */
+   int                beg;           /* first row of cells (from -1)     */
+   int                end;           /* last  row of cells + 1           */
+};
+
+static void gc_coefs_proc(
+   void *arg)
+{
+   GEOCON_COEFS_TASK * task = (GEOCON_COEFS_TASK *)arg;
+   const GEOCON_HDR *  hdr  = task->hdr;
+   int irow;
+   int icol;
+
+   for (irow = task->beg; irow < task->end; irow++)
+   {
+      double * k = task->coefs + GEOCON_COEFS_PER_CELL *
+                   ((size_t)(irow + 1) * (hdr->ncols + 2));
+
+      for (icol = -1; icol <= hdr->ncols; icol++)
+      {
+         float lat[16], lon[16], hgt[16];
+
+         gc_get_window(hdr, irow - 1, icol - 1, 4, 4, lat, lon, hgt);
+         gc_coefs_cell(lat, k);
+         gc_coefs_cell(lon, k + 16);
+         gc_coefs_cell(hgt, k + 32);
+         k += GEOCON_COEFS_PER_CELL;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+ * build the coefficients of all cells
+ */
+static double * gc_coefs_build(
+   const GEOCON_HDR *hdr)
+{
+   GEOCON_COEFS_TASK tasks[GEOCON_MAX_THREADS];
+   size_t ncells = (size_t)(hdr->nrows + 2) * (hdr->ncols + 2);
+   double * coefs;
+   int nrows = hdr->nrows + 2;
+   int n;
+   int i;
+
+   coefs = (double *)gc_memalloc(ncells * GEOCON_COEFS_PER_CELL *
+                                 sizeof(*coefs));
+   if ( coefs == GEOCON_NULL )
+      return GEOCON_NULL;
+
+   n = gc_num_threads(ncells, 64 * 1024);
+   for (i = 0; i < n; i++)
+   {
+      tasks[i].hdr   = hdr;
+      tasks[i].coefs = coefs;
+      tasks[i].beg   = -1 + (int)(((size_t)nrows *  i     ) / n);
+      tasks[i].end   = -1 + (int)(((size_t)nrows * (i + 1)) / n);
+   }
+
+   gc_run_parallel(gc_coefs_proc, tasks, sizeof(tasks[0]), n);
+
+   return coefs;
+}
+
+/*------------------------------------------------------------------------
+ * calculate the shifts for a point using bicubic interpolation
+ */
+static void gc_calculate_shifts_bicubic(
+   const GEOCON_HDR * hdr,
+   double       lat_deg,
+   double       lon_deg,
+   double *     lat_shift,
+   double *     lon_shift,
+   double *     hgt_shift)
+{
+   float        lat[4][4], lon[4][4], hgt[4][4];
+   double       h[4][4];
+   double       c[4];
+   double       a0, a1, a2, a3, d0, d2, d3;
+   double       x_grid_index, y_grid_index;
+   double       dx, dy;
+   int          irow, icol;
+   int          i, j;
+
+   /* get the corner points around our point */
+   {
+      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
+      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+
+      icol = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
+      irow = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
+
+      dx   = (x_grid_index - icol);
+      dy   = (y_grid_index - irow);
+
+      /* use the cell's precomputed polynomial if we have one */
+
+      if ( hdr->coefs != GEOCON_NULL &&
+           irow >= -1 && irow <= hdr->nrows &&
+           icol >= -1 && icol <= hdr->ncols )
+      {
+         const double * k = hdr->coefs + GEOCON_COEFS_PER_CELL *
+            (((size_t)(irow + 1) * (hdr->ncols + 2)) + (icol + 1));
+
+         *lat_shift = gc_coefs_eval(k,      dx, dy);
+         *lon_shift = gc_coefs_eval(k + 16, dx, dy);
+         *hgt_shift = gc_coefs_eval(k + 32, dx, dy);
+         return;
+      }
+
+      /* corner points around p are in this order:
+
+         points            values
+         -------------     ---------------------
+         M   N   O   P     h30   h31   h32   h33
+
+         I   J   K   L     h20   h21   h22   h23
+               p                     p
+         E   F   G   H     h10   h11   h12   h13
+
+         A   B   C   D     h00   h01   h02   h03
+
+         (irow,icol) is at F
+      */
+
+      irow -= 1;
+      icol -= 1;
+      gc_get_window(hdr, irow, icol, 4, 4, lat[0], lon[0], hgt[0]);
+   }
+
+   /* Longitude */
+   {
+      for (i = 0; i < 4; i++)
+      {
+         for (j = 0; j < 4; j ++)
+         {
+            h[i][j] = lon[i][j];
+         }
+      }
+
+      for (j = 0; j < 4; j ++)
+      {
+         a0   = h[1][j];
+         d0   = h[0][j] - a0;
+         d2   = h[2][j] - a0;
+         d3   = h[3][j] - a0;
+         a1   = d2 - (d0/3.0 + d3/6.0);
+         a2   = (d0 + d2)/2.0;
+         a3   = (d3 - d0)/6.0 - d2/2.0;
+         c[j] = a0 + dy * (a1 + dy * (a2 + dy * a3));
+      }
+
+      a0 = c[1];
+      d0 = c[0] - a0;
+      d2 = c[2] - a0;
+      d3 = c[3] - a0;
+      a1 = d2 - (d0/3.0 + d3/6.0);
+      a2 = (d0 + d2)/2.0;
+      a3 = (d3 - d0)/6.0 - d2/2.0;
+      *lon_shift = a0 + dx * (a1 + dx * (a2 + dx * a3));
+   }
+
+   /* Latitude */
+   {
+      for (i = 0; i < 4; i++)
+      {
+         for (j = 0; j < 4; j ++)
+         {
+            h[i][j] = lat[i][j];
+         }
+      }
+
+      for (j = 0; j < 4; j ++)
+      {
+         a0   = h[1][j];
+         d0   = h[0][j] - a0;
+         d2   = h[2][j] - a0;
+         d3   = h[3][j] - a0;
+         a1   = d2 - (d0/3.0 + d3/6.0);
+         a2   = (d0 + d2)/2.0;
+         a3   = (d3 - d0)/6.0 - d2/2.0;
+         c[j] = a0 + dy * (a1 + dy * (a2 + dy * a3));
+      }
+
+      a0 = c[1];
+      d0 = c[0] - a0;
+      d2 = c[2] - a0;
+      d3 = c[3] - a0;
+      a1 = d2 - (d0/3.0 + d3/6.0);
+      a2 = (d0 + d2)/2.0;
+      a3 = (d3 - d0)/6.0 - d2/2.0;
+      *lat_shift = a0 + dx * (a1 + dx * (a2 + dx * a3));
+   }
+
+   /* Height */
+   {
+      for (i = 0; i < 4; i++)
+      {
+         for (j = 0; j < 4; j ++)
+         {
+            h[i][j] = hgt[i][j];
+         }
+      }
+
+      for (j = 0; j < 4; j ++)
+      {
+         a0   = h[1][j];
+         d0   = h[0][j] - a0;
+         d2   = h[2][j] - a0;
+         d3   = h[3][j] - a0;
+         a1   = d2 - (d0/3.0 + d3/6.0);
+         a2   = (d0 + d2)/2.0;
+         a3   = (d3 - d0)/6.0 - d2/2.0;
+         c[j] = a0 + dy * (a1 + dy * (a2 + dy * a3));
+      }
+
+      a0 = c[1];
+      d0 = c[0] - a0;
+      d2 = c[2] - a0;
+      d3 = c[3] - a0;
+      a1 = d2 - (d0/3.0 + d3/6.0);
+      a2 = (d0 + d2)/2.0;
+      a3 = (d3 - d0)/6.0 - d2/2.0;
+      *hgt_shift = a0 + dx * (a1 + dx * (a2 + dx * a3));
+   }
+}
+
+/*------------------------------------------------------------------------
+ * calculate the shifts for a point using biquadratic interpolation
+ */
+static void gc_calculate_shifts_biquadratic(
+   const GEOCON_HDR * hdr,
+   double       lat_deg,
+   double       lon_deg,
+   double *     lat_shift,
+   double *     lon_shift,
+   double *     hgt_shift)
+{
+   float        lat[9], lon[9], hgt[9];
+   float        lft, cen, rgt;
+   double       f0, f1, f2;
+   double       tmp1, tmp2, tmp3;
+   double       x_grid_index, y_grid_index, dx, dy;
+   int          icol_lft, icol_cen, icol_rgt;
+   int          irow_bot, irow_cen, irow_top;
+
+   /* get all edge values */
+   {
+      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
+      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+
+      icol_lft = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
+      icol_cen = icol_lft + 1;
+      icol_rgt = icol_lft + 2;
+
+      irow_bot = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
+      irow_cen = irow_bot + 1;
+      irow_top = irow_bot + 2;
+   }
+
+   /* adjust edges against "phantom" cells */
+   {
+      /* Check right edge */
+      while ( icol_rgt > hdr->ncols )
+      {
+         icol_lft -= 1;
+         icol_cen -= 1;
+         icol_rgt -= 1;
+      }
+
+      /* Check dx and left edge */
+      dx = (lon_deg - hdr->lon_delta * icol_lft - hdr->lon_min) /
+           hdr->lon_delta;
+
+      if ( dx < 0.5 && icol_lft > 0 )
+      {
+         icol_lft -= 1;
+         icol_cen -= 1;
+         icol_rgt -= 1;
+         dx       += 1.0;
+      }
+
+      /* Check top edge */
+      while ( irow_top > hdr->nrows )
+      {
+         irow_bot -= 1;
+         irow_cen -= 1;
+         irow_top -= 1;
+      }
+
+      /* Check dy and bottom edge */
+      dy = (lat_deg - hdr->lat_delta * irow_bot - hdr->lat_min) /
+           hdr->lat_delta;
+
+      if ( dy < 0.5 && irow_bot > 0 )
+      {
+         irow_bot -= 1;
+         irow_cen -= 1;
+         irow_top -= 1;
+         dy       += 1.0;
+      }
+
+      tmp1 = 0.5 * (dx - 1.0);
+      tmp2 = 0.5 * (dy - 1.0);
+   }
+
+   /* get the corner points around our point */
+   {
+      /* corner points around p are in this order:
+
+                        G   H   I
+
+                        D   E   F
+                          p
+         (irow,icol) -> A   B   C
+
+         and are stored in the order A B C D E F G H I.
+      */
+      gc_get_window(hdr, irow_bot, icol_lft, 3, 3, lat, lon, hgt);
+   }
+
+   /* Longitude */
+   {
+      lft  = lon[0];
+      cen  = lon[1];
+      rgt  = lon[2];
+      tmp3 = cen - lft;
+      f0   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      lft  = lon[3];
+      cen  = lon[4];
+      rgt  = lon[5];
+      tmp3 = cen - lft;
+      f1   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      lft  = lon[6];
+      cen  = lon[7];
+      rgt  = lon[8];
+      tmp3 = cen - lft;
+      f2   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      tmp3 = f1 - f0;
+      *lon_shift = f0 + dy * (tmp3 + tmp2 * (f2 - f1 - tmp3));
+   }
+
+   /* Latitude */
+   {
+      lft  = lat[0];
+      cen  = lat[1];
+      rgt  = lat[2];
+      tmp3 = cen - lft;
+      f0   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      lft  = lat[3];
+      cen  = lat[4];
+      rgt  = lat[5];
+      tmp3 = cen - lft;
+      f1   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      lft  = lat[6];
+      cen  = lat[7];
+      rgt  = lat[8];
+      tmp3 = cen - lft;
+      f2   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      tmp3 = f1 - f0;
+      *lat_shift = f0 + dy * (tmp3 + tmp2 * (f2 - f1 - tmp3));
+   }
+
+   /* Height */
+   {
+      lft  = hgt[0];
+      cen  = hgt[1];
+      rgt  = hgt[2];
+      tmp3 = cen - lft;
+      f0   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      lft  = hgt[3];
+      cen  = hgt[4];
+      rgt  = hgt[5];
+      tmp3 = cen - lft;
+      f1   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      lft  = hgt[6];
+      cen  = hgt[7];
+      rgt  = hgt[8];
+      tmp3 = cen - lft;
+      f2   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+
+      tmp3 = f1 - f0;
+      *hgt_shift = f0 + dy * (tmp3 + tmp2 * (f2 - f1 - tmp3));
+   }
+}
+
+/*------------------------------------------------------------------------
+ * calculate the shifts for a point using natural spline interpolation
+ */
+static void gc_calculate_shifts_natspline(
+   const GEOCON_HDR * hdr,
+   double       lat_deg,
+   double       lon_deg,
+   double *     lat_shift,
+   double *     lon_shift,
+   double *     hgt_shift)
+{
+   float        lat[4], lon[4], hgt[4];
+   double       x_grid_index, y_grid_index, dx, dy;
+   double       a00, a01, a10, a11;
+   double       v_a00, v_a01, v_a10, v_a11;
+   double       v_dx2;
+   double       v_dy2;
+   double       v_1_minus_dx;
+   double       v_1_minus_dy;
+   double       v_1_minus_dx2;
+   double       v_1_minus_dy2;
+   double       v_3_minus_2_times_dx;
+   double       v_3_minus_2_times_dy;
+   double       v_3_minus_2_times_1_minus_dx;
+   double       v_3_minus_2_times_1_minus_dy;
+   int          icol, irow;
+
+   /* get the corner points around our point */
+   {
+      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
+      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+
+      icol = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
+      irow = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
+
+      dx   = (x_grid_index - icol);
+      dy   = (y_grid_index - irow);
+
+      v_dx2                        = (dx * dx);
+      v_dy2                        = (dy * dy);
+
+      v_1_minus_dx                 = (1 - dx);
+      v_1_minus_dy                 = (1 - dy);
+
+      v_1_minus_dx2                = (v_1_minus_dx * v_1_minus_dx);
+      v_1_minus_dy2                = (v_1_minus_dy * v_1_minus_dy);
+
+      v_3_minus_2_times_dx         = (3 - 2 * dx);
+      v_3_minus_2_times_dy         = (3 - 2 * dy);
+
+      v_3_minus_2_times_1_minus_dx = (3 - 2 * v_1_minus_dx);
+      v_3_minus_2_times_1_minus_dy = (3 - 2 * v_1_minus_dy);
+
+      v_a00 = v_1_minus_dx2 *
+              v_1_minus_dy2 *
+              v_3_minus_2_times_1_minus_dx *
+              v_3_minus_2_times_1_minus_dy;
+
+      v_a01 = v_dy2 *
+              v_1_minus_dx2 *
+              v_3_minus_2_times_dy *
+              v_3_minus_2_times_1_minus_dx;
+
+      v_a10 = v_dx2 *
+              v_1_minus_dy2 *
+              v_3_minus_2_times_dx *
+              v_3_minus_2_times_1_minus_dy;
+
+      v_a11 = v_dx2 *
+              v_dy2 *
+              v_3_minus_2_times_dx *
+              v_3_minus_2_times_dy;
+
+      /* corner points around p are in this order:
+
+                        points    values
+                        -----     ---------
+                        C   D     a01   a11
+                          p           p
+         (irow,icol) -> A   B     a00   a10
+
+         and are stored in the order A B C D.
+      */
+      gc_get_window(hdr, irow, icol, 2, 2, lat, lon, hgt);
+   }
+
+   /* Longitude */
+   {
+      a00 = lon[0];
+      a10 = lon[1];
+      a01 = lon[2];
+      a11 = lon[3];
+
+      *lon_shift = a00 * v_a00 +
+                   a01 * v_a01 +
+                   a10 * v_a10 +
+                   a11 * v_a11 ;
+   }
+
+   /* Latitude */
+   {
+      a00 = lat[0];
+      a10 = lat[1];
+      a01 = lat[2];
+      a11 = lat[3];
+
+      *lat_shift = a00 * v_a00 +
+                   a01 * v_a01 +
+                   a10 * v_a10 +
+                   a11 * v_a11 ;
+   }
+
+   /* Height */
+   {
+      a00 = hgt[0];
+      a10 = hgt[1];
+      a01 = hgt[2];
+      a11 = hgt[3];
+
+      *hgt_shift = a00 * v_a00 +
+                   a01 * v_a01 +
+                   a10 * v_a10 +
+                   a11 * v_a11 ;
+   }
+}
+
+/*------------------------------------------------------------------------
+ * calculate the shifts for a point
+ *
+ * The original GEOCON specification only provided for an abrupt edge
+ * around the grid, which resulted in the posibility of a point near
+ * an edge being shifted to outside the grid, and thus not being able to
+ * be inversed back into the grid. Not good.
+ *
+ * Thus, we pretend that there is a one-cell zone around each grid
+ * that has a shift value of zero.  This allows for a point that was
+ * shifted out to be properly shifted back, and also allows for
+ * a gradual change rather than an abrupt jump.  Much better!
+ *
+ * Note that this will cause shift values near an edge to be different
+ * between this algorithm's results and the original algorithm's results.
+ *
+ * Note also that we defer applying any conversion factors until after
+ * doing any interpolation, in order to preserve accuracy.
+ */
+static void gc_calculate_shifts(
+   const GEOCON_HDR * hdr,
+   int          interp,
+   double       lat_deg,
+   double       lon_deg,
+   double *     lat_shift,
+   double *     lon_shift,
+   double *     hgt_shift)
+{
+   switch (interp)
+   {
+      case GEOCON_INTERP_BILINEAR:
+         gc_calculate_shifts_bilinear   (hdr, lat_deg,   lon_deg,
+                                              lat_shift, lon_shift, hgt_shift);
+         break;
+
+      case GEOCON_INTERP_BICUBIC:
+         gc_calculate_shifts_bicubic    (hdr, lat_deg,   lon_deg,
+                                              lat_shift, lon_shift, hgt_shift);
+         break;
+
+      default:
+      case GEOCON_INTERP_BIQUADRATIC:
+         gc_calculate_shifts_biquadratic(hdr, lat_deg,   lon_deg,
+                                              lat_shift, lon_shift, hgt_shift);
+         break;
+
+      case GEOCON_INTERP_NATSPLINE:
+         gc_calculate_shifts_natspline  (hdr, lat_deg,   lon_deg,
+                                              lat_shift, lon_shift, hgt_shift);
+         break;
+   }
+
+   *lat_shift /= hdr->horz_scale;
+   *lon_shift /= hdr->horz_scale;
+   *hgt_shift /= hdr->vert_scale;
+}
+
+/*------------------------------------------------------------------------
+ * do a forward transformation of point "i"
+ *
+ * Returns 1 if the point was transformed, or 0 if it is outside the grid.
+ */
+static int gc_forward_point(
+   const GEOCON_HDR * hdr,
+   int          interp,
+   double       deg_factor,
+   double       hgt_factor,
+   GEOCON_COORD coord[],
+   double       h[],
+   int          i)
+{
+   double lat_deg, lat_shift;
+   double lon_deg, lon_shift;
+   double hgt_mtr, hgt_shift;
+
+   lat_deg =          (coord[i][GEOCON_COORD_LAT] * deg_factor);
+   lon_deg = gc_delta((coord[i][GEOCON_COORD_LON] * deg_factor));
+   hgt_mtr = (h == GEOCON_NULL) ? 0 :       (h[i] * hgt_factor);
+
+   if ( GEOCON_GT(lat_deg, hdr->lat_min_ghost) &&
+        GEOCON_LT(lat_deg, hdr->lat_max_ghost) &&
+        GEOCON_GT(lon_deg, hdr->lon_min_ghost) &&
+        GEOCON_LT(lon_deg, hdr->lon_max_ghost) )
+   {
+      gc_calculate_shifts(hdr, interp, lat_deg, lon_deg,
+         &lat_shift, &lon_shift, &hgt_shift);
+
+      lat_deg += lat_shift;
+      lon_deg += lon_shift;
+      hgt_mtr += hgt_shift;
+
+      coord[i][GEOCON_COORD_LAT] = (         lat_deg  / deg_factor);
+      coord[i][GEOCON_COORD_LON] = (gc_delta(lon_deg) / deg_factor);
+      if (h != GEOCON_NULL) h[i] = (         hgt_mtr  / hgt_factor);
+
+      return 1;
+   }
+
+   return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* internal SIMD routines                                                     */
+/* -------------------------------------------------------------------------- */
+
+#ifdef GEOCON_AVX2
+
+/*------------------------------------------------------------------------
+ * AVX2 batch transformations
+ *
+ * These do the same as gc_forward_point() for 4 points at a time.  Each
+ * group of 4 points gets its grid indexes, its interpolation windows, and
+ * its shifts computed in AVX2 registers.  Window values outside the grid
+ * (the phantom cells) are masked out of the gathers and come back as
+ * zeros, just as gc_get_window() returns them, so points near the edges
+ * need no special handling.
+ *
+ * Error bound: the kernels use the same types (floats where the scalar
+ * code subtracts two floats, and doubles elsewhere) and the same order
+ * of operations as the scalar code, with no fused multiply-adds, so the
+ * results are the same bit for bit (0 ULP).  This holds as long as the
+ * scalar code is not itself compiled to use fused multiply-adds (as
+ * GCC's -ffp-contract=fast would do with -mfma), in which case each of
+ * its multiply-adds may differ by its last bit of rounding.
+ *
+ * The upper halves of the AVX registers are cleared before calling any
+ * non-AVX code (such as fmod() in gc_delta()), which can otherwise be
+ * very slow.
+ */
+
+/*------------------------------------------------------------------------
+ * check if a batch transformation can be done with AVX2
+ */
+static GEOCON_BOOL gc_batch_avx2(
+   const GEOCON_HDR * hdr,
+   int                interp)
+{
+   switch (interp)
+   {
+      case GEOCON_INTERP_DEFAULT:
+      case GEOCON_INTERP_BILINEAR:
+      case GEOCON_INTERP_BIQUADRATIC:
+      case GEOCON_INTERP_NATSPLINE:
+         break;
+
+      case GEOCON_INTERP_BICUBIC:
+         /* the coefficient grid is used instead if there is one */
+         if ( hdr->coefs != GEOCON_NULL )
+            return FALSE;
+         break;
+
+      default:
+         return FALSE;
+   }
+
+   if ( hdr->points == GEOCON_NULL && hdr->planes == GEOCON_NULL )
+      return FALSE;
+
+   return gc_cpu_has_avx2();
+}
+
+/*------------------------------------------------------------------------
+ * get the grid index of the cell that each of 4 grid coordinates is in
+ *
+ * This is -1 for a negative value, as in the scalar code.
+ */
+static GEOCON_AVX2_FUNC __m256d gc_avx2_index(
+   __m256d v)
+{
+   return _mm256_blendv_pd(
+             _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC),
+             _mm256_set1_pd(-1.0),
+             _mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_LT_OQ));
+}
+
+/*------------------------------------------------------------------------
+ * get the lat, lon, and hgt shift values of a window of 4 points
+ *
+ * This does what gc_get_window() does for each of 4 points, whose first
+ * rows & cols are in "irow" & "icol".  The values are stored by component
+ * (0 = lat, 1 = lon, 2 = hgt), then by row and col.
+ */
+static GEOCON_AVX2_FUNC void gc_avx2_window(
+   const GEOCON_HDR * hdr,
+   __m256d            irow,
+   __m256d            icol,
+   int                nr,
+   int                nc,
+   __m128             win[3][GEOCON_WINDOW_MAX * GEOCON_WINDOW_MAX])
+{
+   const float * base[3];
+   __m128i       row0 = _mm256_cvttpd_epi32(irow);
+   __m128i       col0 = _mm256_cvttpd_epi32(icol);
+   __m256i       ncols = _mm256_set1_epi64x(hdr->ncols);
+   int           stride;
+   int           i;
+   int           j;
+   int           k;
+
+   if ( hdr->planes != GEOCON_NULL )
+   {
+      size_t npts = (size_t)hdr->nrows * hdr->ncols;
+
+      base[0] = hdr->planes;
+      base[1] = hdr->planes + npts;
+      base[2] = hdr->planes + npts + npts;
+      stride  = 1;
+   }
+   else
+   {
+      base[0] = &hdr->points->lat_value;
+      base[1] = &hdr->points->lon_value;
+      base[2] = &hdr->points->hgt_value;
+      stride  = 3;
+   }
+
+   for (i = 0; i < nr; i++)
+   {
+      __m128i row  = _mm_add_epi32(row0, _mm_set1_epi32(i));
+      __m128i rok  = _mm_andnot_si128(
+                        _mm_cmplt_epi32(row, _mm_setzero_si128()),
+                        _mm_cmplt_epi32(row, _mm_set1_epi32(hdr->nrows)));
+      __m256i roff = _mm256_mul_epu32(_mm256_cvtepi32_epi64(row), ncols);
+
+      for (j = 0; j < nc; j++)
+      {
+         __m128i col = _mm_add_epi32(col0, _mm_set1_epi32(j));
+         __m128i ok  = _mm_andnot_si128(
+                          _mm_cmplt_epi32(col, _mm_setzero_si128()),
+                          _mm_cmplt_epi32(col, _mm_set1_epi32(hdr->ncols)));
+         __m256i idx = _mm256_add_epi64(roff, _mm256_cvtepi32_epi64(col));
+
+         ok = _mm_and_si128(ok, rok);
+         if ( stride == 3 )
+            idx = _mm256_add_epi64(idx, _mm256_add_epi64(idx, idx));
+
+         for (k = 0; k < 3; k++)
+         {
+            win[k][(i * nc) + j] =
+               _mm256_mask_i64gather_ps(_mm_setzero_ps(), base[k], idx,
+                                        _mm_castsi128_ps(ok), 4);
+         }
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+ * calculate the bilinear shifts of 4 points
+ *
+ * This is gc_calculate_shifts_bilinear() for 4 points, whose grid
+ * coordinates are in "x" & "y".
+ */
+static GEOCON_AVX2_FUNC void gc_avx2_bilinear(
+   const GEOCON_HDR * hdr,
+   __m256d            x,
+   __m256d            y,
+   double             shifts[3][4])
+{
+   __m128  win[3][GEOCON_WINDOW_MAX * GEOCON_WINDOW_MAX];
+   __m256d icol = gc_avx2_index(x);
+   __m256d irow = gc_avx2_index(y);
+   __m256d dx   = _mm256_sub_pd(x, icol);
+   __m256d dy   = _mm256_sub_pd(y, irow);
+   int     k;
+
+   gc_avx2_window(hdr, irow, icol, 2, 2, win);
+
+   for (k = 0; k < 3; k++)
+   {
+      __m256d h1 = _mm256_cvtps_pd(win[k][0]);
+      __m256d h2 = _mm256_cvtps_pd(win[k][1]);
+      __m256d h3 = _mm256_cvtps_pd(win[k][2]);
+      __m256d h4 = _mm256_cvtps_pd(win[k][3]);
+
+      __m256d a00 = h1;
+      __m256d a10 = _mm256_sub_pd(h2, h1);
+      __m256d a01 = _mm256_sub_pd(h3, h1);
+      __m256d a11 = _mm256_sub_pd(_mm256_sub_pd(h1, h2),
+                                  _mm256_sub_pd(h3, h4));
+      __m256d r;
+
+      r = _mm256_add_pd(a00, _mm256_mul_pd(a10, dx));
+      r = _mm256_add_pd(r,   _mm256_mul_pd(a01, dy));
+      r = _mm256_add_pd(r,   _mm256_mul_pd(_mm256_mul_pd(a11, dx), dy));
+
+      _mm256_storeu_pd(shifts[k], r);
+   }
+}
+
+/*------------------------------------------------------------------------
+ * evaluate one biquadratic row (or col) of 4 points
+ *
+ * This is "lft + d * (tmp3 + t * (rgt - cen - tmp3))", with
+ * tmp3 = (cen - lft) done in floats, as in the scalar code.
+ */
+static GEOCON_AVX2_FUNC __m256d gc_avx2_quad_flt(
+   __m128  lft,
+   __m128  cen,
+   __m128  rgt,
+   __m256d d,
+   __m256d t)
+{
+   __m256d tmp3 = _mm256_cvtps_pd(_mm_sub_ps(cen, lft));
+   __m256d diff = _mm256_sub_pd(_mm256_cvtps_pd(_mm_sub_ps(rgt, cen)), tmp3);
+
+   return _mm256_add_pd(_mm256_cvtps_pd(lft),
+             _mm256_mul_pd(d, _mm256_add_pd(tmp3, _mm256_mul_pd(t, diff))));
+}
+
+/*------------------------------------------------------------------------
+ * calculate the biquadratic shifts of 4 points
+ *
+ * This is gc_calculate_shifts_biquadratic() for 4 points.  The edge
+ * adjustments are done with min and blend masks instead of branches.
+ */
+static GEOCON_AVX2_FUNC void gc_avx2_biquadratic(
+   const GEOCON_HDR * hdr,
+   __m256d            lon,
+   __m256d            lat,
+   __m256d            x,
+   __m256d            y,
+   double             shifts[3][4])
+{
+   const __m256d zero = _mm256_setzero_pd();
+   const __m256d half = _mm256_set1_pd(0.5);
+   const __m256d one  = _mm256_set1_pd(1.0);
+   const __m256d lon_dd = _mm256_set1_pd(hdr->lon_delta);
+   const __m256d lat_dd = _mm256_set1_pd(hdr->lat_delta);
+   __m128  win[3][GEOCON_WINDOW_MAX * GEOCON_WINDOW_MAX];
+   __m256d icol, irow, dx, dy, tmp1, tmp2, adj;
+   int     k;
+
+   /* check right & top edges */
+
+   icol = _mm256_min_pd(gc_avx2_index(x),
+                        _mm256_set1_pd((double)(hdr->ncols - 2)));
+   irow = _mm256_min_pd(gc_avx2_index(y),
+                        _mm256_set1_pd((double)(hdr->nrows - 2)));
+
+   /* check dx and left edge, & dy and bottom edge */
+
+   dx  = _mm256_div_pd(
+            _mm256_sub_pd(_mm256_sub_pd(lon, _mm256_mul_pd(lon_dd, icol)),
+                          _mm256_set1_pd(hdr->lon_min)), lon_dd);
+   adj = _mm256_and_pd(_mm256_cmp_pd(dx,   half, _CMP_LT_OQ),
+                       _mm256_cmp_pd(icol, zero, _CMP_GT_OQ));
+   icol = _mm256_sub_pd(icol, _mm256_and_pd(adj, one));
+   dx   = _mm256_blendv_pd(dx, _mm256_add_pd(dx, one), adj);
+
+   dy  = _mm256_div_pd(
+            _mm256_sub_pd(_mm256_sub_pd(lat, _mm256_mul_pd(lat_dd, irow)),
+                          _mm256_set1_pd(hdr->lat_min)), lat_dd);
+   adj = _mm256_and_pd(_mm256_cmp_pd(dy,   half, _CMP_LT_OQ),
+                       _mm256_cmp_pd(irow, zero, _CMP_GT_OQ));
+   irow = _mm256_sub_pd(irow, _mm256_and_pd(adj, one));
+   dy   = _mm256_blendv_pd(dy, _mm256_add_pd(dy, one), adj);
+
+   tmp1 = _mm256_mul_pd(half, _mm256_sub_pd(dx, one));
+   tmp2 = _mm256_mul_pd(half, _mm256_sub_pd(dy, one));
+
+   gc_avx2_window(hdr, irow, icol, 3, 3, win);
+
+   for (k = 0; k < 3; k++)
+   {
+      __m256d f0 = gc_avx2_quad_flt(win[k][0], win[k][1], win[k][2], dx, tmp1);
+      __m256d f1 = gc_avx2_quad_flt(win[k][3], win[k][4], win[k][5], dx, tmp1);
+      __m256d f2 = gc_avx2_quad_flt(win[k][6], win[k][7], win[k][8], dx, tmp1);
+      __m256d tmp3 = _mm256_sub_pd(f1, f0);
+      __m256d diff = _mm256_sub_pd(_mm256_sub_pd(f2, f1), tmp3);
+
+      _mm256_storeu_pd(shifts[k],
+         _mm256_add_pd(f0, _mm256_mul_pd(dy,
+            _mm256_add_pd(tmp3, _mm256_mul_pd(tmp2, diff)))));
+   }
+}
+
+/*------------------------------------------------------------------------
+ * evaluate the cubic through 4 values at -1, 0, 1, & 2 at "d" for 4 points
+ */
+static GEOCON_AVX2_FUNC __m256d gc_avx2_cubic(
+   __m256d v0,
+   __m256d v1,
+   __m256d v2,
+   __m256d v3,
+   __m256d d)
+{
+   const __m256d two   = _mm256_set1_pd(2.0);
+   const __m256d three = _mm256_set1_pd(3.0);
+   const __m256d six   = _mm256_set1_pd(6.0);
+   __m256d a0 = v1;
+   __m256d d0 = _mm256_sub_pd(v0, a0);
+   __m256d d2 = _mm256_sub_pd(v2, a0);
+   __m256d d3 = _mm256_sub_pd(v3, a0);
+   __m256d a1 = _mm256_sub_pd(d2, _mm256_add_pd(_mm256_div_pd(d0, three),
+                                                _mm256_div_pd(d3, six)));
+   __m256d a2 = _mm256_div_pd(_mm256_add_pd(d0, d2), two);
+   __m256d a3 = _mm256_sub_pd(_mm256_div_pd(_mm256_sub_pd(d3, d0), six),
+                              _mm256_div_pd(d2, two));
+
+   return _mm256_add_pd(a0, _mm256_mul_pd(d,
+             _mm256_add_pd(a1, _mm256_mul_pd(d,
+                _mm256_add_pd(a2, _mm256_mul_pd(d, a3))))));
+}
+
+/*------------------------------------------------------------------------
+ * calculate the bicubic shifts of 4 points
+ *
+ * This is gc_calculate_shifts_bicubic() for 4 points (without any
+ * coefficient grid).  The 4x4 window is gathered once, and the column
+ * cubics and the final row cubic of all three components are evaluated
+ * 4 points at a time.
+ */
+static GEOCON_AVX2_FUNC void gc_avx2_bicubic(
+   const GEOCON_HDR * hdr,
+   __m256d            x,
+   __m256d            y,
+   double             shifts[3][4])
+{
+   const __m256d one = _mm256_set1_pd(1.0);
+   __m128  win[3][GEOCON_WINDOW_MAX * GEOCON_WINDOW_MAX];
+   __m256d icol = gc_avx2_index(x);
+   __m256d irow = gc_avx2_index(y);
+   __m256d dx   = _mm256_sub_pd(x, icol);
+   __m256d dy   = _mm256_sub_pd(y, irow);
+   int     j;
+   int     k;
+
+   gc_avx2_window(hdr, _mm256_sub_pd(irow, one), _mm256_sub_pd(icol, one),
+                  4, 4, win);
+
+   for (k = 0; k < 3; k++)
+   {
+      __m256d c[4];
+
+      for (j = 0; j < 4; j++)
+      {
+         c[j] = gc_avx2_cubic(_mm256_cvtps_pd(win[k][ 0 + j]),
+                              _mm256_cvtps_pd(win[k][ 4 + j]),
+                              _mm256_cvtps_pd(win[k][ 8 + j]),
+                              _mm256_cvtps_pd(win[k][12 + j]), dy);
+      }
+
+      _mm256_storeu_pd(shifts[k], gc_avx2_cubic(c[0], c[1], c[2], c[3], dx));
+   }
+}
+
+/*------------------------------------------------------------------------
+ * calculate the natural spline shifts of 4 points
+ *
+ * This is gc_calculate_shifts_natspline() for 4 points.  The corner
+ * weights are computed once for all 4 points and applied to the 2x2
+ * windows of all three components.
+ */
+static GEOCON_AVX2_FUNC void gc_avx2_natspline(
+   const GEOCON_HDR * hdr,
+   __m256d            x,
+   __m256d            y,
+   double             shifts[3][4])
+{
+   const __m256d one   = _mm256_set1_pd(1.0);
+   const __m256d two   = _mm256_set1_pd(2.0);
+   const __m256d three = _mm256_set1_pd(3.0);
+   __m128  win[3][GEOCON_WINDOW_MAX * GEOCON_WINDOW_MAX];
+   __m256d icol = gc_avx2_index(x);
+   __m256d irow = gc_avx2_index(y);
+   __m256d dx   = _mm256_sub_pd(x, icol);
+   __m256d dy   = _mm256_sub_pd(y, irow);
+   __m256d dx2, dy2, mdx, mdy, mdx2, mdy2, tdx, tdy, tmdx, tmdy;
+   __m256d w00, w01, w10, w11;
+   int     k;
+
+   dx2  = _mm256_mul_pd(dx, dx);
+   dy2  = _mm256_mul_pd(dy, dy);
+   mdx  = _mm256_sub_pd(one, dx);
+   mdy  = _mm256_sub_pd(one, dy);
+   mdx2 = _mm256_mul_pd(mdx, mdx);
+   mdy2 = _mm256_mul_pd(mdy, mdy);
+   tdx  = _mm256_sub_pd(three, _mm256_mul_pd(two, dx));
+   tdy  = _mm256_sub_pd(three, _mm256_mul_pd(two, dy));
+   tmdx = _mm256_sub_pd(three, _mm256_mul_pd(two, mdx));
+   tmdy = _mm256_sub_pd(three, _mm256_mul_pd(two, mdy));
+
+   w00 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(mdx2, mdy2), tmdx), tmdy);
+   w01 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(dy2,  mdx2), tdy),  tmdx);
+   w10 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(dx2,  mdy2), tdx),  tmdy);
+   w11 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(dx2,  dy2),  tdx),  tdy);
+
+   gc_avx2_window(hdr, irow, icol, 2, 2, win);
+
+   for (k = 0; k < 3; k++)
+   {
+      __m256d r;
+
+      r = _mm256_mul_pd(_mm256_cvtps_pd(win[k][0]), w00);
+      r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_cvtps_pd(win[k][2]), w01));
+      r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_cvtps_pd(win[k][1]), w10));
+      r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_cvtps_pd(win[k][3]), w11));
+
+      _mm256_storeu_pd(shifts[k], r);
+   }
+}
+
+/*------------------------------------------------------------------------
+ * do a forward transformation of as many groups of 4 points as possible
+ *
+ * Returns the number of points processed (a multiple of 4), and adds
+ * the number transformed to "*pnum".
+ */
+static GEOCON_AVX2_FUNC int gc_forward_avx2(
+   const GEOCON_HDR * hdr,
+   int                interp,
+   double             deg_factor,
+   double             hgt_factor,
+   int                n,
+   GEOCON_COORD       coord[],
+   double             h[],
+   int *              pnum)
+{
+   int i;
+   int k;
+
+   for (i = 0; i + 4 <= n; i += 4)
+   {
+      double lat_deg[4];
+      double lon_deg[4];
+      double shifts[3][4];
+      int    mask = 0;
+
+      for (k = 0; k < 4; k++)
+      {
+         lat_deg[k] =          (coord[i+k][GEOCON_COORD_LAT] * deg_factor);
+         lon_deg[k] = gc_delta((coord[i+k][GEOCON_COORD_LON] * deg_factor));
+
+         if ( GEOCON_GT(lat_deg[k], hdr->lat_min_ghost) &&
+              GEOCON_LT(lat_deg[k], hdr->lat_max_ghost) &&
+              GEOCON_GT(lon_deg[k], hdr->lon_min_ghost) &&
+              GEOCON_LT(lon_deg[k], hdr->lon_max_ghost) )
+         {
+            mask |= (1 << k);
+         }
+      }
+
+      if ( mask == 0 )
+         continue;
+
+      /* calculate the shifts (of any points outside the grid too) */
+      {
+         __m256d lat = _mm256_loadu_pd(lat_deg);
+         __m256d lon = _mm256_loadu_pd(lon_deg);
+         __m256d x   = _mm256_div_pd(
+                          _mm256_sub_pd(lon, _mm256_set1_pd(hdr->lon_min)),
+                          _mm256_set1_pd(hdr->lon_delta));
+         __m256d y   = _mm256_div_pd(
+                          _mm256_sub_pd(lat, _mm256_set1_pd(hdr->lat_min)),
+                          _mm256_set1_pd(hdr->lat_delta));
+
+         switch (interp)
+         {
+            case GEOCON_INTERP_BILINEAR:
+               gc_avx2_bilinear   (hdr,           x, y, shifts);
+               break;
+
+            case GEOCON_INTERP_BICUBIC:
+               gc_avx2_bicubic    (hdr,           x, y, shifts);
+               break;
+
+            case GEOCON_INTERP_NATSPLINE:
+               gc_avx2_natspline  (hdr,           x, y, shifts);
+               break;
+
+            default:
+               gc_avx2_biquadratic(hdr, lon, lat, x, y, shifts);
+               break;
+         }
+      }
+      _mm256_zeroupper();
+
+      /* apply the shifts as gc_forward_point() does */
+
+      for (k = 0; k < 4; k++)
+      {
+         double lat;
+         double lon;
+
+         if ( (mask & (1 << k)) == 0 )
+            continue;
+
+         lat = lat_deg[k] + (shifts[0][k] / hdr->horz_scale);
+         lon = lon_deg[k] + (shifts[1][k] / hdr->horz_scale);
+
+         coord[i+k][GEOCON_COORD_LAT] = (         lat  / deg_factor);
+         coord[i+k][GEOCON_COORD_LON] = (gc_delta(lon) / deg_factor);
+         if ( h != GEOCON_NULL )
+         {
+            double hgt = (h[i+k] * hgt_factor) +
+                         (shifts[2][k] / hdr->vert_scale);
+
+            h[i+k] = (hgt / hgt_factor);
+         }
+         (*pnum)++;
+      }
+   }
+
+   return i;
+}
+
+#endif /* GEOCON_AVX2 */
+
+/* -------------------------------------------------------------------------- */
+/* external GEOCON routines                                                   */
+/* -------------------------------------------------------------------------- */
+
+/*------------------------------------------------------------------------
+ * Determine the file type of a name
+ *
+ * This is done solely by checking the filename extension.
+ * No examination of the file contents (if any) is done.
+ */
+int geocon_filetype(const char *pathname)
+{
+   const char *ext;
+
+   if ( pathname == GEOCON_NULL || *pathname == 0 )
+      return GEOCON_FILE_TYPE_UNK;
+
+   ext = strrchr(pathname, '.');
+   if ( ext != GEOCON_NULL )
+   {
+      ext++;
+
+      if ( gc_strcmp_i(ext, GEOCON_BIN_EXTENSION) == 0 )
+         return GEOCON_FILE_TYPE_BIN;
+
+      if ( gc_strcmp_i(ext, GEOCON_ASC_EXTENSION) == 0 )
+         return GEOCON_FILE_TYPE_ASC;
+   }
+
+   return GEOCON_FILE_TYPE_UNK;
+}
+
+/*------------------------------------------------------------------------
+ * get a string associated with an error code
+ */
+const char * geocon_errmsg(int err_num, char msg_buf[])
+{
+   const GEOCON_ERRS *e;
+
+   for (e = gc_errlist; e->err_num >= 0; e++)
+   {
+      if ( e->err_num == err_num )
+      {
+         if ( msg_buf == NULL )
+         {
+            return e->err_msg;
+         }
+         else
+         {
+            strcpy(msg_buf, e->err_msg);
+            return msg_buf;
+         }
+      }
+   }
+
+   if ( msg_buf == NULL )
+   {
+      return "?";
+   }
+   else
+   {
+      sprintf(msg_buf, "%d", err_num);
+      return msg_buf;
+   }
+}
+
+/*------------------------------------------------------------------------
+ * create an empty GEOCON header
+ */
+GEOCON_HDR * geocon_create()
+{
+   GEOCON_HDR * hdr = (GEOCON_HDR *)gc_memalloc(sizeof(*hdr));
+
+   if ( hdr != GEOCON_NULL )
+   {
+      memset(hdr, 0, sizeof(*hdr));
+      hdr->fhdr.magic    = GEOCON_HDR_MAGIC;
+      hdr->fhdr.version  = GEOCON_HDR_VERSION;
+      hdr->fhdr.hdrlen   = GEOCON_FILE_HDR_LEN;
+   }
+
+   return hdr;
+}
+
+/*------------------------------------------------------------------------
+ * open a file and load its header
+ */
+static GEOCON_HDR * gc_load_open(
+   const char    *pathname,
+   int           *prc)
+{
+   GEOCON_HDR * hdr;
+   int filetype;
+   int rc;
+
+   if ( pathname == GEOCON_NULL || *pathname == 0 )
+   {
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return GEOCON_NULL;
+   }
+
+   filetype = geocon_filetype(pathname);
+   if ( filetype == GEOCON_FILE_TYPE_UNK )
+   {
+      *prc = GEOCON_ERR_UNKNOWN_FILETYPE;
+      return GEOCON_NULL;
+   }
 
-         (irow,icol) is at F
-      */
+   hdr = geocon_create();
+   if ( hdr == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return GEOCON_NULL;
+   }
 
-      irow -= 1;
-      icol -= 1;
-      for (i = 0; i < 4; i++)
-      {
-         ir = irow + i;
-         for (j = 0; j < 4; j ++)
-         {
-            gc_get_shift(hdr, &pt[i][j], ir, icol + j);
-         }
-      }
+   hdr->fp = fopen(pathname, "rb");
+   if ( hdr->fp == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_FILE_NOT_FOUND;
+      gc_memdealloc(hdr);
+      return GEOCON_NULL;
    }
 
-   /* Longitude */
+   strcpy(hdr->pathname, pathname);
+   hdr->filetype = filetype;
+
+   rc = gc_load_hdr(hdr, prc);
+   if ( rc != 0 )
    {
-      for (i = 0; i < 4; i++)
+      geocon_delete(hdr);
+      return GEOCON_NULL;
+   }
+
+   return hdr;
+}
+
+/*------------------------------------------------------------------------
+ * release the data of an object
+ */
+static void gc_free_data(
+   GEOCON_HDR    *hdr)
+{
+   if ( hdr->map_addr != GEOCON_NULL )
+      gc_unmap_file(hdr->map_addr, hdr->map_len);
+   else
+   if ( hdr->points   != GEOCON_NULL )
+      gc_memdealloc(hdr->points);
+   else
+   if ( hdr->qpoints  != GEOCON_NULL )
+      gc_memdealloc(hdr->qpoints);
+   else
+   if ( hdr->planes   != GEOCON_NULL )
+      gc_memdealloc(hdr->planes);
+
+   if ( hdr->coefs    != GEOCON_NULL )
+      gc_memdealloc(hdr->coefs);
+
+   hdr->map_addr = GEOCON_NULL;
+   hdr->map_len  = 0;
+   hdr->points   = GEOCON_NULL;
+   hdr->qpoints  = GEOCON_NULL;
+   hdr->planes   = GEOCON_NULL;
+   hdr->coefs    = GEOCON_NULL;
+}
+
+/*------------------------------------------------------------------------
+ * convert an object's data in memory to 16-bit values
+ *
+ * Each component is given the smallest step that lets its whole range
+ * fit in 16 bits, so its max error is just half of that step.
+ */
+static int gc_quant_compact(
+   GEOCON_HDR *hdr,
+   int        *prc)
+{
+   static const double no_max[3] = { 0.0, 0.0, 0.0 };
+   size_t npts = (size_t)hdr->nrows * hdr->ncols;
+   GEOCON_QUANT quant;
+   unsigned char * qpts;
+   double vmin[3];
+   double vmax[3];
+   size_t plen = 0;
+   size_t i;
+   int    k;
+
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT &&
+        hdr->quant.size[0] == 2 &&
+        hdr->quant.size[1] == 2 &&
+        hdr->quant.size[2] == 2 )
+   {
+      return 0;
+   }
+
+   gc_quant_range(hdr, vmin, vmax);
+
+   memset(&quant, 0, sizeof(quant));
+
+   for (k = 0; k < 3; k++)
+   {
+      double half = (vmax[k] - vmin[k]) / 2;
+
+      quant.size[k] = 2;
+      quant.base[k] = vmin[k] + half;
+      quant.step[k] = (half == 0.0) ? 1.0 : (half / GEOCON_QUANT_MAX_2);
+      plen         += (size_t)quant.size[k];
+   }
+
+   if ( gc_quant_check(hdr, &quant, no_max, prc) != 0 )
+      return -1;
+
+   qpts = (unsigned char *)gc_memalloc(npts * plen);
+   if ( qpts == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return -1;
+   }
+
+   for (i = 0; i < npts; i++)
+   {
+      GEOCON_POINT pt;
+
+      gc_get_point(hdr, i, &pt);
+      gc_encode_point(&quant, &pt, qpts + (i * plen));
+   }
+
+   gc_free_data(hdr);
+   hdr->qpoints  = qpts;
+   hdr->quant    = quant;
+   hdr->data_fmt = GEOCON_DATA_QUANT;
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * convert an object's data in memory to planes
+ */
+static int gc_make_planes(
+   GEOCON_HDR *hdr,
+   int        *prc)
+{
+   size_t npts = (size_t)hdr->nrows * hdr->ncols;
+   float * planes;
+   size_t i;
+
+   planes = (float *)gc_memalloc(3 * npts * sizeof(*planes));
+   if ( planes == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return -1;
+   }
+
+   for (i = 0; i < npts; i++)
+   {
+      GEOCON_POINT pt;
+
+      gc_get_point(hdr, i, &pt);
+      planes[i]               = pt.lat_value;
+      planes[i + npts]        = pt.lon_value;
+      planes[i + npts + npts] = pt.hgt_value;
+   }
+
+   gc_free_data(hdr);
+   hdr->planes   = planes;
+   hdr->data_fmt = GEOCON_DATA_FLOAT;
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+ * load the data of an object whose header has been loaded
+ *
+ * If this fails, the object is left with no data.
+ */
+static int gc_load_rest(
+   GEOCON_HDR    *hdr,
+   GEOCON_EXTENT *ext,
+   int            load_data,
+   int           *prc)
+{
+   int rc = 0;
+
+   if ( load_data )
+   {
+      rc = gc_load_data(hdr, ext, load_data, prc);
+      if ( rc == 0 && load_data == GEOCON_LOAD_COMPACT )
+         rc = gc_quant_compact(hdr, prc);
+      if ( rc == 0 && load_data == GEOCON_LOAD_PLANAR )
+         rc = gc_make_planes(hdr, prc);
+
+      /* Done with the file whether there were errors or not. */
+      fclose(hdr->fp);
+      hdr->fp = GEOCON_NULL;
+
+      if ( hdr->blocks != GEOCON_NULL )
       {
-         for (j = 0; j < 4; j ++)
-         {
-            h[i][j] = pt[i][j].lon_value;
-         }
+         gc_blocks_delete((GEOCON_BLOCKS *)hdr->blocks);
+         hdr->blocks = GEOCON_NULL;
       }
 
-      for (j = 0; j < 4; j ++)
+      if ( rc != 0 )
+         gc_free_data(hdr);
+   }
+   else
+   {
+      if ( hdr->filetype == GEOCON_FILE_TYPE_BIN )
       {
-         a0   = h[1][j];
-         d0   = h[0][j] - a0;
-         d2   = h[2][j] - a0;
-         d3   = h[3][j] - a0;
-         a1   = d2 - (d0/3.0 + d3/6.0);
-         a2   = (d0 + d2)/2.0;
-         a3   = (d3 - d0)/6.0 - d2/2.0;
-         c[j] = a0 + dy * (a1 + dy * (a2 + dy * a3));
+         hdr->mutex = (void *)gc_mutex_create();
+      }
+      else
+      {
+         /* No reading on-the-fly if it's an ascii file. */
+         fclose(hdr->fp);
+         hdr->fp = GEOCON_NULL;
       }
+   }
 
-      a0 = c[1];
-      d0 = c[0] - a0;
-      d2 = c[2] - a0;
-      d3 = c[3] - a0;
-      a1 = d2 - (d0/3.0 + d3/6.0);
-      a2 = (d0 + d2)/2.0;
-      a3 = (d3 - d0)/6.0 - d2/2.0;
-      *lon_shift = a0 + dx * (a1 + dx * (a2 + dx * a3));
+   return rc;
+}
+
+/*------------------------------------------------------------------------
+ * asynchronous load routines
+ *
+ * The loading thread owns the object until it sets "done".  Both "done"
+ * and "rc" are protected by "mutex", which also makes everything the
+ * thread did visible to whoever sees "done" set.  The thread is joined
+ * by the first caller to wait for it, under "join_mutex".
+ */
+typedef struct geocon_loader GEOCON_LOADER;
+struct geocon_loader
+{
+   GEOCON_HDR *   hdr;              /* object being loaded              */
+   GEOCON_EXTENT  ext;              /* copy of the extent (if any)      */
+   GEOCON_BOOL    use_ext;          /* TRUE if an extent was given      */
+   int            load_data;        /* load mode                        */
+
+   void *         thread;           /* loading thread or null if joined */
+   void *         join_mutex;       /* MUTEX for joining the thread     */
+
+   void *         mutex;            /* MUTEX for the following          */
+   GEOCON_BOOL    done;             /* TRUE when the load is done       */
+   int            rc;               /* result of the load               */
+};
+
+static void gc_loader_delete(
+   GEOCON_LOADER *ldr)
+{
+   if ( ldr->join_mutex != GEOCON_NULL )
+      gc_mutex_delete(ldr->join_mutex);
+
+   if ( ldr->mutex      != GEOCON_NULL )
+      gc_mutex_delete(ldr->mutex);
+
+   gc_memdealloc(ldr);
+}
+
+static void gc_loader_proc(
+   void          *arg)
+{
+   GEOCON_LOADER * ldr = (GEOCON_LOADER *)arg;
+   int rc = GEOCON_ERR_OK;
+
+   gc_load_rest(ldr->hdr, ldr->use_ext ? &ldr->ext : GEOCON_NULL,
+      ldr->load_data, &rc);
+
+   gc_mutex_enter(ldr->mutex);
+   {
+      ldr->rc   = rc;
+      ldr->done = TRUE;
    }
+   gc_mutex_leave(ldr->mutex);
+}
 
-   /* Latitude */
+static GEOCON_BOOL gc_load_is_done(
+   const GEOCON_HDR *hdr,
+   int              *prc)
+{
+   GEOCON_LOADER * ldr = (GEOCON_LOADER *)hdr->loader;
+   GEOCON_BOOL done = TRUE;
+
+   *prc = GEOCON_ERR_OK;
+
+   if ( ldr != GEOCON_NULL )
    {
-      for (i = 0; i < 4; i++)
+      gc_mutex_enter(ldr->mutex);
       {
-         for (j = 0; j < 4; j ++)
-         {
-            h[i][j] = pt[i][j].lat_value;
-         }
+         done = ldr->done;
+         if ( done )
+            *prc = ldr->rc;
       }
+      gc_mutex_leave(ldr->mutex);
+   }
 
-      for (j = 0; j < 4; j ++)
+   return done;
+}
+
+static int gc_load_wait(
+   const GEOCON_HDR *hdr,
+   int              *prc)
+{
+   GEOCON_LOADER * ldr = (GEOCON_LOADER *)hdr->loader;
+
+   *prc = GEOCON_ERR_OK;
+
+   if ( ldr != GEOCON_NULL )
+   {
+      gc_mutex_enter(ldr->join_mutex);
       {
-         a0   = h[1][j];
-         d0   = h[0][j] - a0;
-         d2   = h[2][j] - a0;
-         d3   = h[3][j] - a0;
-         a1   = d2 - (d0/3.0 + d3/6.0);
-         a2   = (d0 + d2)/2.0;
-         a3   = (d3 - d0)/6.0 - d2/2.0;
-         c[j] = a0 + dy * (a1 + dy * (a2 + dy * a3));
+         if ( ldr->thread != GEOCON_NULL )
+         {
+            gc_thread_join(ldr->thread);
+            ldr->thread = GEOCON_NULL;
+         }
       }
+      gc_mutex_leave(ldr->join_mutex);
 
-      a0 = c[1];
-      d0 = c[0] - a0;
-      d2 = c[2] - a0;
-      d3 = c[3] - a0;
-      a1 = d2 - (d0/3.0 + d3/6.0);
-      a2 = (d0 + d2)/2.0;
-      a3 = (d3 - d0)/6.0 - d2/2.0;
-      *lat_shift = a0 + dx * (a1 + dx * (a2 + dx * a3));
+      gc_load_is_done(hdr, prc);
+   }
+
+   return (*prc == GEOCON_ERR_OK) ? 0 : -1;
+}
+
+/*------------------------------------------------------------------------
+ * check if an object's data can be used for transforming points
+ */
+static GEOCON_BOOL gc_data_ready(
+   const GEOCON_HDR *hdr)
+{
+   int rc;
+
+   return gc_load_is_done(hdr, &rc) && rc == GEOCON_ERR_OK;
+}
+
+/*------------------------------------------------------------------------
+ * load header and optionally the data
+ */
+GEOCON_HDR * geocon_load(
+   const char    *pathname,
+   GEOCON_EXTENT *ext,
+   int            load_data,
+   int           *prc)
+{
+   GEOCON_HDR * hdr;
+   int gcerr;
+   int rc;
+
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+   hdr = gc_load_open(pathname, prc);
+   if ( hdr == GEOCON_NULL )
+      return GEOCON_NULL;
+
+   rc = gc_load_rest(hdr, ext, load_data, prc);
+   if ( rc != 0 )
+   {
+      geocon_delete(hdr);
+      return GEOCON_NULL;
    }
 
-   /* Height */
+   return hdr;
+}
+
+/*------------------------------------------------------------------------
+ * load header and start loading the data in the background
+ */
+GEOCON_HDR * geocon_load_async(
+   const char    *pathname,
+   GEOCON_EXTENT *ext,
+   int            load_data,
+   int           *prc)
+{
+   GEOCON_HDR * hdr;
+   int gcerr;
+   int rc;
+
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+   hdr = gc_load_open(pathname, prc);
+   if ( hdr == GEOCON_NULL )
+      return GEOCON_NULL;
+
+   if ( load_data )
    {
-      for (i = 0; i < 4; i++)
+      GEOCON_LOADER * ldr = (GEOCON_LOADER *)gc_memalloc(sizeof(*ldr));
+
+      if ( ldr == GEOCON_NULL )
       {
-         for (j = 0; j < 4; j ++)
-         {
-            h[i][j] = pt[i][j].hgt_value;
-         }
+         *prc = GEOCON_ERR_NO_MEMORY;
+         geocon_delete(hdr);
+         return GEOCON_NULL;
       }
 
-      for (j = 0; j < 4; j ++)
+      memset(ldr, 0, sizeof(*ldr));
+      ldr->hdr        = hdr;
+      ldr->use_ext    = (ext != GEOCON_NULL);
+      ldr->load_data  = load_data;
+      ldr->join_mutex = gc_mutex_create();
+      ldr->mutex      = gc_mutex_create();
+      if ( ext != GEOCON_NULL )
+         ldr->ext     = *ext;
+
+      if ( ldr->join_mutex != GEOCON_NULL && ldr->mutex != GEOCON_NULL )
+         ldr->thread  = gc_thread_create(gc_loader_proc, ldr);
+
+      if ( ldr->thread != GEOCON_NULL )
       {
-         a0   = h[1][j];
-         d0   = h[0][j] - a0;
-         d2   = h[2][j] - a0;
-         d3   = h[3][j] - a0;
-         a1   = d2 - (d0/3.0 + d3/6.0);
-         a2   = (d0 + d2)/2.0;
-         a3   = (d3 - d0)/6.0 - d2/2.0;
-         c[j] = a0 + dy * (a1 + dy * (a2 + dy * a3));
+         hdr->loader = ldr;
+         return hdr;
       }
 
-      a0 = c[1];
-      d0 = c[0] - a0;
-      d2 = c[2] - a0;
-      d3 = c[3] - a0;
-      a1 = d2 - (d0/3.0 + d3/6.0);
-      a2 = (d0 + d2)/2.0;
-      a3 = (d3 - d0)/6.0 - d2/2.0;
-      *hgt_shift = a0 + dx * (a1 + dx * (a2 + dx * a3));
+      /* No thread, so just load it here. */
+      gc_loader_delete(ldr);
+   }
+
+   rc = gc_load_rest(hdr, ext, load_data, prc);
+   if ( rc != 0 )
+   {
+      geocon_delete(hdr);
+      return GEOCON_NULL;
    }
+
+   return hdr;
 }
 
 /*------------------------------------------------------------------------
- * calculate the shifts for a point using biquadratic interpolation
+ * check if an asynchronous load is done
  */
-static void gc_calculate_shifts_biquadratic(
-   const GEOCON_HDR * hdr,
-   double       lat_deg,
-   double       lon_deg,
-   double *     lat_shift,
-   double *     lon_shift,
-   double *     hgt_shift)
+GEOCON_BOOL geocon_load_done(
+   const GEOCON_HDR *hdr,
+   int              *prc)
 {
-   GEOCON_POINT ptA, ptB, ptC, ptD, ptE, ptF, ptG, ptH, ptI;
-   float        lft, cen, rgt;
-   double       f0, f1, f2;
-   double       tmp1, tmp2, tmp3;
-   double       x_grid_index, y_grid_index, dx, dy;
-   int          icol_lft, icol_cen, icol_rgt;
-   int          irow_bot, irow_cen, irow_top;
+   int gcerr;
 
-   /* get all edge values */
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+   if ( hdr == GEOCON_NULL )
    {
-      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
-      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return TRUE;
+   }
 
-      icol_lft = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
-      icol_cen = icol_lft + 1;
-      icol_rgt = icol_lft + 2;
+   return gc_load_is_done(hdr, prc);
+}
 
-      irow_bot = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
-      irow_cen = irow_bot + 1;
-      irow_top = irow_bot + 2;
-   }
+/*------------------------------------------------------------------------
+ * wait for an asynchronous load to be done
+ */
+int geocon_load_wait(
+   const GEOCON_HDR *hdr,
+   int              *prc)
+{
+   int gcerr;
 
-   /* adjust edges against "phantom" cells */
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+   if ( hdr == GEOCON_NULL )
    {
-      /* Check right edge */
-      while ( icol_rgt > hdr->ncols )
-      {
-         icol_lft -= 1;
-         icol_cen -= 1;
-         icol_rgt -= 1;
-      }
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return -1;
+   }
 
-      /* Check dx and left edge */
-      dx = (lon_deg - hdr->lon_delta * icol_lft - hdr->lon_min) /
-           hdr->lon_delta;
+   return gc_load_wait(hdr, prc);
+}
 
-      if ( dx < 0.5 && icol_lft > 0 )
-      {
-         icol_lft -= 1;
-         icol_cen -= 1;
-         icol_rgt -= 1;
-         dx       += 1.0;
-      }
+/*------------------------------------------------------------------------
+ * registry of shared objects
+ *
+ * Objects opened by geocon_open() are kept in a process-wide list, keyed
+ * by canonical pathname, extent, and load mode, and are shared by all who
+ * open them.  The list and all reference counts are protected by the
+ * global lock, which is not held while loading a file.  If two threads
+ * load the same object at once, the second one to finish just deletes
+ * its copy and uses the first.
+ */
+typedef struct geocon_entry GEOCON_ENTRY;
+struct geocon_entry
+{
+   GEOCON_ENTRY * next;             /* next entry in registry           */
+   char           pathname[GEOCON_MAX_PATH_LEN]; /* canonical pathname  */
+   GEOCON_BOOL    use_ext;          /* TRUE if an extent was given      */
+   GEOCON_EXTENT  ext;              /* extent (if any)                  */
+   int            load_data;        /* load mode                        */
+   GEOCON_HDR *   hdr;              /* shared object                    */
+   int            refs;             /* number of references to it       */
+};
 
-      /* Check top edge */
-      while ( irow_top > hdr->nrows )
-      {
-         irow_bot -= 1;
-         irow_cen -= 1;
-         irow_top -= 1;
-      }
+static GEOCON_ENTRY * gc_registry = GEOCON_NULL;
 
-      /* Check dy and bottom edge */
-      dy = (lat_deg - hdr->lat_delta * irow_bot - hdr->lat_min) /
-           hdr->lat_delta;
+/*------------------------------------------------------------------------
+ * find an entry in the registry (the global lock must be held)
+ */
+static GEOCON_ENTRY * gc_registry_find(
+   const GEOCON_ENTRY *key)
+{
+   GEOCON_ENTRY * e;
 
-      if ( dy < 0.5 && irow_bot > 0 )
+   for (e = gc_registry; e != GEOCON_NULL; e = e->next)
+   {
+      if ( e->load_data == key->load_data                  &&
+           e->use_ext   == key->use_ext                    &&
+           strcmp(e->pathname, key->pathname) == 0         &&
+           (!e->use_ext || (e->ext.slat == key->ext.slat &&
+                            e->ext.wlon == key->ext.wlon &&
+                            e->ext.nlat == key->ext.nlat &&
+                            e->ext.elon == key->ext.elon)) )
       {
-         irow_bot -= 1;
-         irow_cen -= 1;
-         irow_top -= 1;
-         dy       += 1.0;
+         return e;
       }
-
-      tmp1 = 0.5 * (dx - 1.0);
-      tmp2 = 0.5 * (dy - 1.0);
    }
 
-   /* get the corner points around our point */
-   {
-      /* corner points around p are in this order:
+   return GEOCON_NULL;
+}
 
-                        G   H   I
+/*------------------------------------------------------------------------
+ * release a reference to a registered object
+ *
+ * Returns TRUE if that was the last reference, in which case the object
+ * has been removed from the registry and should be deleted.
+ */
+static GEOCON_BOOL gc_registry_release(
+   GEOCON_HDR    *hdr)
+{
+   GEOCON_ENTRY * entry = (GEOCON_ENTRY *)hdr->entry;
+   GEOCON_ENTRY **pe;
+   GEOCON_BOOL    last;
 
-                        D   E   F
-                          p
-         (irow,icol) -> A   B   C
-      */
-      gc_get_shift(hdr, &ptA, irow_bot, icol_lft);
-      gc_get_shift(hdr, &ptB, irow_bot, icol_cen);
-      gc_get_shift(hdr, &ptC, irow_bot, icol_rgt);
-      gc_get_shift(hdr, &ptD, irow_cen, icol_lft);
-      gc_get_shift(hdr, &ptE, irow_cen, icol_cen);
-      gc_get_shift(hdr, &ptF, irow_cen, icol_rgt);
-      gc_get_shift(hdr, &ptG, irow_top, icol_lft);
-      gc_get_shift(hdr, &ptH, irow_top, icol_cen);
-      gc_get_shift(hdr, &ptI, irow_top, icol_rgt);
+   gc_global_lock();
+   {
+      last = (--entry->refs == 0);
+      if ( last )
+      {
+         for (pe = &gc_registry; *pe != GEOCON_NULL; pe = &(*pe)->next)
+         {
+            if ( *pe == entry )
+            {
+               *pe = entry->next;
+               break;
+            }
+         }
+      }
    }
+   gc_global_unlock();
 
-   /* Longitude */
+   if ( last )
    {
-      lft  = ptA.lon_value;
-      cen  = ptB.lon_value;
-      rgt  = ptC.lon_value;
-      tmp3 = cen - lft;
-      f0   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+      hdr->entry = GEOCON_NULL;
+      gc_memdealloc(entry);
+   }
 
-      lft  = ptD.lon_value;
-      cen  = ptE.lon_value;
-      rgt  = ptF.lon_value;
-      tmp3 = cen - lft;
-      f1   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+   return last;
+}
 
-      lft  = ptG.lon_value;
-      cen  = ptH.lon_value;
-      rgt  = ptI.lon_value;
-      tmp3 = cen - lft;
-      f2   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+/*------------------------------------------------------------------------
+ * open a shared object
+ */
+GEOCON_HDR * geocon_open(
+   const char    *pathname,
+   GEOCON_EXTENT *ext,
+   int            load_data,
+   int           *prc)
+{
+   GEOCON_ENTRY * entry;
+   GEOCON_ENTRY * e;
+   GEOCON_HDR   * hdr;
+   int gcerr;
 
-      tmp3 = f1 - f0;
-      *lon_shift = f0 + dy * (tmp3 + tmp2 * (f2 - f1 - tmp3));
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+   if ( pathname == GEOCON_NULL || *pathname == 0 )
+   {
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return GEOCON_NULL;
    }
 
-   /* Latitude */
+   entry = (GEOCON_ENTRY *)gc_memalloc(sizeof(*entry));
+   if ( entry == GEOCON_NULL )
    {
-      lft  = ptA.lat_value;
-      cen  = ptB.lat_value;
-      rgt  = ptC.lat_value;
-      tmp3 = cen - lft;
-      f0   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return GEOCON_NULL;
+   }
 
-      lft  = ptD.lat_value;
-      cen  = ptE.lat_value;
-      rgt  = ptF.lat_value;
-      tmp3 = cen - lft;
-      f1   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+   /* Don't guess at a name, or different files could share an entry. */
+   memset(entry, 0, sizeof(*entry));
+   if ( gc_full_path(pathname, entry->pathname) != 0 )
+   {
+      gc_memdealloc(entry);
+      *prc = GEOCON_ERR_FILE_NOT_FOUND;
+      return GEOCON_NULL;
+   }
+   entry->use_ext   = (ext != GEOCON_NULL);
+   entry->load_data = load_data;
+   entry->refs      = 1;
+   if ( ext != GEOCON_NULL )
+      entry->ext    = *ext;
 
-      lft  = ptG.lat_value;
-      cen  = ptH.lat_value;
-      rgt  = ptI.lat_value;
-      tmp3 = cen - lft;
-      f2   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+   /* see if we already have it */
 
-      tmp3 = f1 - f0;
-      *lat_shift = f0 + dy * (tmp3 + tmp2 * (f2 - f1 - tmp3));
+   gc_global_lock();
+   {
+      e = gc_registry_find(entry);
+      if ( e != GEOCON_NULL )
+         e->refs++;
    }
+   gc_global_unlock();
 
-   /* Height */
+   if ( e != GEOCON_NULL )
    {
-      lft  = ptA.hgt_value;
-      cen  = ptB.hgt_value;
-      rgt  = ptC.hgt_value;
-      tmp3 = cen - lft;
-      f0   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
-
-      lft  = ptD.hgt_value;
-      cen  = ptE.hgt_value;
-      rgt  = ptF.hgt_value;
-      tmp3 = cen - lft;
-      f1   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+      gc_memdealloc(entry);
+      return e->hdr;
+   }
 
-      lft  = ptG.hgt_value;
-      cen  = ptH.hgt_value;
-      rgt  = ptI.hgt_value;
-      tmp3 = cen - lft;
-      f2   = lft + dx * (tmp3 + tmp1 * (rgt - cen - tmp3));
+   /* no - load it and add it, unless someone beat us to it */
 
-      tmp3 = f1 - f0;
-      *hgt_shift = f0 + dy * (tmp3 + tmp2 * (f2 - f1 - tmp3));
+   hdr = geocon_load(pathname, ext, load_data, prc);
+   if ( hdr == GEOCON_NULL )
+   {
+      gc_memdealloc(entry);
+      return GEOCON_NULL;
    }
-}
 
-/*------------------------------------------------------------------------
- * calculate the shifts for a point using natural spline interpolation
- */
-static void gc_calculate_shifts_natspline(
-   const GEOCON_HDR * hdr,
-   double       lat_deg,
-   double       lon_deg,
-   double *     lat_shift,
-   double *     lon_shift,
-   double *     hgt_shift)
-{
-   GEOCON_POINT ptA, ptB, ptC, ptD;
-   double       x_grid_index, y_grid_index, dx, dy;
-   double       a00, a01, a10, a11;
-   double       v_a00, v_a01, v_a10, v_a11;
-   double       v_dx2;
-   double       v_dy2;
-   double       v_1_minus_dx;
-   double       v_1_minus_dy;
-   double       v_1_minus_dx2;
-   double       v_1_minus_dy2;
-   double       v_3_minus_2_times_dx;
-   double       v_3_minus_2_times_dy;
-   double       v_3_minus_2_times_1_minus_dx;
-   double       v_3_minus_2_times_1_minus_dy;
-   int          icol, irow;
+   gc_global_lock();
+   {
+      e = gc_registry_find(entry);
+      if ( e != GEOCON_NULL )
+      {
+         e->refs++;
+      }
+      else
+      {
+         entry->hdr  = hdr;
+         entry->next = gc_registry;
+         gc_registry = entry;
+         hdr->entry  = entry;
+      }
+   }
+   gc_global_unlock();
 
-   /* get the corner points around our point */
+   if ( e != GEOCON_NULL )
    {
-      x_grid_index = (lon_deg - hdr->lon_min) / hdr->lon_delta;
-      y_grid_index = (lat_deg - hdr->lat_min) / hdr->lat_delta;
+      geocon_delete(hdr);
+      gc_memdealloc(entry);
+      return e->hdr;
+   }
 
-      icol = (x_grid_index < 0.0) ? -1 : (int)x_grid_index;
-      irow = (y_grid_index < 0.0) ? -1 : (int)y_grid_index;
+   return hdr;
+}
 
-      dx   = (x_grid_index - icol);
-      dy   = (y_grid_index - irow);
+/*------------------------------------------------------------------------
+ * set the size of the tile cache for reading data on-the-fly
+ */
+int geocon_set_cache(
+   GEOCON_HDR    *hdr,
+   size_t         max_bytes,
+   int           *prc)
+{
+   GEOCON_CACHE * cache = GEOCON_NULL;
+   int gcerr;
 
-      v_dx2                        = (dx * dx);
-      v_dy2                        = (dy * dy);
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
 
-      v_1_minus_dx                 = (1 - dx);
-      v_1_minus_dy                 = (1 - dy);
+   if ( hdr == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return -1;
+   }
 
-      v_1_minus_dx2                = (v_1_minus_dx * v_1_minus_dx);
-      v_1_minus_dy2                = (v_1_minus_dy * v_1_minus_dy);
+   /* There is nothing to cache if the data is not read on-the-fly. */
+   if ( hdr->fp == GEOCON_NULL || gc_data_in_memory(hdr) )
+      return 0;
 
-      v_3_minus_2_times_dx         = (3 - 2 * dx);
-      v_3_minus_2_times_dy         = (3 - 2 * dy);
+   if ( max_bytes > 0 )
+   {
+      cache = gc_cache_create(hdr, max_bytes);
+      if ( cache == GEOCON_NULL )
+      {
+         *prc = GEOCON_ERR_NO_MEMORY;
+         return -1;
+      }
+   }
 
-      v_3_minus_2_times_1_minus_dx = (3 - 2 * v_1_minus_dx);
-      v_3_minus_2_times_1_minus_dy = (3 - 2 * v_1_minus_dy);
+   if ( hdr->cache != GEOCON_NULL )
+      gc_cache_delete((GEOCON_CACHE *)hdr->cache);
+   hdr->cache = (void *)cache;
 
-      v_a00 = v_1_minus_dx2 *
-              v_1_minus_dy2 *
-              v_3_minus_2_times_1_minus_dx *
-              v_3_minus_2_times_1_minus_dy;
+   return 0;
+}
 
-      v_a01 = v_dy2 *
-              v_1_minus_dx2 *
-              v_3_minus_2_times_dy *
-              v_3_minus_2_times_1_minus_dx;
+/*------------------------------------------------------------------------
+ * shared-memory segments
+ *
+ * A segment consists of a GEOCON_SHM struct, which includes an image of
+ * the header (with all pointers cleared), followed by the points array
+ * at a fixed offset.  Since nothing in it is an address, it can be mapped
+ * anywhere.  The magic number is stored last (after a barrier), so a
+ * segment that is still being published is seen as invalid.
+ */
+#define GEOCON_SHM_MAGIC   0x47435348  /* "GCSH" */
+#define GEOCON_SHM_ALIGN   64
 
-      v_a10 = v_dx2 *
-              v_1_minus_dy2 *
-              v_3_minus_2_times_dx *
-              v_3_minus_2_times_1_minus_dy;
+typedef struct geocon_shm GEOCON_SHM;
+struct geocon_shm
+{
+   int            magic;            /* GEOCON_SHM_MAGIC if complete     */
+   int            hdr_len;          /* size of GEOCON_HDR image         */
+   size_t         seg_len;          /* length of segment                */
+   size_t         points_offset;    /* offset to points array           */
+   GEOCON_HDR     hdr;              /* header image                     */
+};
 
-      v_a11 = v_dx2 *
-              v_dy2 *
-              v_3_minus_2_times_dx *
-              v_3_minus_2_times_dy;
+#define GEOCON_SHM_POINTS_OFFSET \
+   ( ((sizeof(GEOCON_SHM) + GEOCON_SHM_ALIGN - 1) / GEOCON_SHM_ALIGN) * \
+      GEOCON_SHM_ALIGN )
 
-      /* corner points around p are in this order:
+/*------------------------------------------------------------------------
+ * build or free the bicubic coefficients of an object
+ */
+int geocon_set_coefs(
+   GEOCON_HDR    *hdr,
+   GEOCON_BOOL    build,
+   int           *prc)
+{
+   int gcerr;
 
-                        points    values
-                        -----     ---------
-                        C   D     a01   a11
-                          p           p
-         (irow,icol) -> A   B     a00   a10
-      */
-      gc_get_shift(hdr, &ptA, irow  , icol  );
-      gc_get_shift(hdr, &ptB, irow  , icol+1);
-      gc_get_shift(hdr, &ptC, irow+1, icol  );
-      gc_get_shift(hdr, &ptD, irow+1, icol+1);
-   }
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
 
-   /* Longitude */
+   if ( hdr == GEOCON_NULL )
    {
-      a00 = ptA.lon_value;
-      a10 = ptB.lon_value;
-      a01 = ptC.lon_value;
-      a11 = ptD.lon_value;
-
-      *lon_shift = a00 * v_a00 +
-                   a01 * v_a01 +
-                   a10 * v_a10 +
-                   a11 * v_a11 ;
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return -1;
    }
 
-   /* Latitude */
-   {
-      a00 = ptA.lat_value;
-      a10 = ptB.lat_value;
-      a01 = ptC.lat_value;
-      a11 = ptD.lat_value;
+   if ( gc_load_wait(hdr, prc) != 0 )
+      return -1;
 
-      *lat_shift = a00 * v_a00 +
-                   a01 * v_a01 +
-                   a10 * v_a10 +
-                   a11 * v_a11 ;
+   if ( hdr->coefs != GEOCON_NULL )
+   {
+      gc_memdealloc(hdr->coefs);
+      hdr->coefs = GEOCON_NULL;
    }
 
-   /* Height */
+   if ( !build )
+      return 0;
+
+   if ( !gc_data_in_memory(hdr) )
    {
-      a00 = ptA.hgt_value;
-      a10 = ptB.hgt_value;
-      a01 = ptC.hgt_value;
-      a11 = ptD.hgt_value;
+      *prc = GEOCON_ERR_NO_DATA;
+      return -1;
+   }
 
-      *hgt_shift = a00 * v_a00 +
-                   a01 * v_a01 +
-                   a10 * v_a10 +
-                   a11 * v_a11 ;
+   hdr->coefs = gc_coefs_build(hdr);
+   if ( hdr->coefs == GEOCON_NULL )
+   {
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return -1;
    }
+
+   return 0;
 }
 
 /*------------------------------------------------------------------------
- * calculate the shifts for a point
- *
- * The original GEOCON specification only provided for an abrupt edge
- * around the grid, which resulted in the posibility of a point near
- * an edge being shifted to outside the grid, and thus not being able to
- * be inversed back into the grid. Not good.
- *
- * Thus, we pretend that there is a one-cell zone around each grid
- * that has a shift value of zero.  This allows for a point that was
- * shifted out to be properly shifted back, and also allows for
- * a gradual change rather than an abrupt jump.  Much better!
- *
- * Note that this will cause shift values near an edge to be different
- * between this algorithm's results and the original algorithm's results.
- *
- * Note also that we defer applying any conversion factors until after
- * doing any interpolation, in order to preserve accuracy.
+ * publish an object's data in a shared-memory segment
  */
-static void gc_calculate_shifts(
-   const GEOCON_HDR * hdr,
-   int          interp,
-   double       lat_deg,
-   double       lon_deg,
-   double *     lat_shift,
-   double *     lon_shift,
-   double *     hgt_shift)
+int geocon_publish(
+   const GEOCON_HDR *hdr,
+   const char       *name,
+   int              *prc)
 {
-   switch (interp)
-   {
-      case GEOCON_INTERP_BILINEAR:
-         gc_calculate_shifts_bilinear   (hdr, lat_deg,   lon_deg,
-                                              lat_shift, lon_shift, hgt_shift);
-         break;
+#ifndef GEOCON_SHM_NOT_SUPPORTED
+   GEOCON_SHM * shm;
+   size_t points_len;
+   size_t seg_len;
+#endif
+   int gcerr;
 
-      case GEOCON_INTERP_BICUBIC:
-         gc_calculate_shifts_bicubic    (hdr, lat_deg,   lon_deg,
-                                              lat_shift, lon_shift, hgt_shift);
-         break;
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
 
-      default:
-      case GEOCON_INTERP_BIQUADRATIC:
-         gc_calculate_shifts_biquadratic(hdr, lat_deg,   lon_deg,
-                                              lat_shift, lon_shift, hgt_shift);
-         break;
+#ifdef GEOCON_SHM_NOT_SUPPORTED
+   GEOCON_UNUSED_PARAMETER(hdr);
+   GEOCON_UNUSED_PARAMETER(name);
 
-      case GEOCON_INTERP_NATSPLINE:
-         gc_calculate_shifts_natspline  (hdr, lat_deg,   lon_deg,
-                                              lat_shift, lon_shift, hgt_shift);
-         break;
-   }
+   *prc = GEOCON_ERR_NOT_SUPPORTED;
+   return -1;
+#else
 
-   *lat_shift /= hdr->horz_scale;
-   *lon_shift /= hdr->horz_scale;
-   *hgt_shift /= hdr->vert_scale;
-}
+   if ( hdr == GEOCON_NULL || name == GEOCON_NULL || *name == 0 )
+   {
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return -1;
+   }
 
-/* -------------------------------------------------------------------------- */
-/* external GEOCON routines                                                   */
-/* -------------------------------------------------------------------------- */
+   if ( gc_load_wait(hdr, prc) != 0 )
+      return -1;
 
-/*------------------------------------------------------------------------
- * Determine the file type of a name
- *
- * This is done solely by checking the filename extension.
- * No examination of the file contents (if any) is done.
- */
-int geocon_filetype(const char *pathname)
-{
-   const char *ext;
+   if ( !gc_data_in_memory(hdr) )
+   {
+      *prc = GEOCON_ERR_NO_DATA;
+      return -1;
+   }
 
-   if ( pathname == GEOCON_NULL || *pathname == 0 )
-      return GEOCON_FILE_TYPE_UNK;
+   points_len = (size_t)hdr->nrows * hdr->ncols * gc_point_len(hdr);
+   seg_len    = GEOCON_SHM_POINTS_OFFSET + points_len;
 
-   ext = strrchr(pathname, '.');
-   if ( ext != GEOCON_NULL )
+   shm = (GEOCON_SHM *)gc_shm_create(name, seg_len);
+   if ( shm == GEOCON_NULL )
    {
-      ext++;
+      *prc = GEOCON_ERR_CANNOT_OPEN_FILE;
+      return -1;
+   }
 
-      if ( gc_strcmp_i(ext, GEOCON_BIN_EXTENSION) == 0 )
-         return GEOCON_FILE_TYPE_BIN;
+   memset(shm, 0, sizeof(*shm));
+   shm->hdr_len       = (int)sizeof(shm->hdr);
+   shm->seg_len       = seg_len;
+   shm->points_offset = GEOCON_SHM_POINTS_OFFSET;
+
+   shm->hdr           = *hdr;
+   shm->hdr.fp        = GEOCON_NULL;
+   shm->hdr.mutex     = GEOCON_NULL;
+   shm->hdr.cache     = GEOCON_NULL;
+   shm->hdr.blocks    = GEOCON_NULL;
+   shm->hdr.points    = GEOCON_NULL;
+   shm->hdr.qpoints   = GEOCON_NULL;
+   shm->hdr.planes    = GEOCON_NULL;
+   shm->hdr.coefs     = GEOCON_NULL;
+   shm->hdr.map_addr  = GEOCON_NULL;
+   shm->hdr.map_len   = 0;
+   shm->hdr.loader    = GEOCON_NULL;
+   shm->hdr.entry     = GEOCON_NULL;
+
+   if ( hdr->qpoints != GEOCON_NULL )
+      memcpy((char *)shm + shm->points_offset, hdr->qpoints, points_len);
+   else
+   if ( hdr->points  != GEOCON_NULL )
+      memcpy((char *)shm + shm->points_offset, hdr->points,  points_len);
+   else
+   {
+      /* planes are published as points */
+      GEOCON_POINT * pts = (GEOCON_POINT *)((char *)shm + shm->points_offset);
+      size_t i;
 
-      if ( gc_strcmp_i(ext, GEOCON_ASC_EXTENSION) == 0 )
-         return GEOCON_FILE_TYPE_ASC;
+      for (i = 0; i < (size_t)hdr->nrows * hdr->ncols; i++)
+         gc_get_point(hdr, i, &pts[i]);
    }
 
-   return GEOCON_FILE_TYPE_UNK;
+   /* Everything above must be visible before the magic number is. */
+   gc_shm_barrier();
+   shm->magic         = GEOCON_SHM_MAGIC;
+
+   gc_unmap_file(shm, seg_len);
+   return 0;
+#endif
 }
 
 /*------------------------------------------------------------------------
- * get a string associated with an error code
+ * attach to a shared-memory segment
  */
-const char * geocon_errmsg(int err_num, char msg_buf[])
+GEOCON_HDR * geocon_attach(
+   const char    *name,
+   int           *prc)
 {
-   const GEOCON_ERRS *e;
+#ifndef GEOCON_SHM_NOT_SUPPORTED
+   GEOCON_HDR * hdr;
+   GEOCON_SHM * shm;
+   size_t len = 0;
+#endif
+   int gcerr;
 
-   for (e = gc_errlist; e->err_num >= 0; e++)
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+#ifdef GEOCON_SHM_NOT_SUPPORTED
+   GEOCON_UNUSED_PARAMETER(name);
+
+   *prc = GEOCON_ERR_NOT_SUPPORTED;
+   return GEOCON_NULL;
+#else
+
+   if ( name == GEOCON_NULL || *name == 0 )
    {
-      if ( e->err_num == err_num )
-      {
-         if ( msg_buf == NULL )
-         {
-            return e->err_msg;
-         }
-         else
-         {
-            strcpy(msg_buf, e->err_msg);
-            return msg_buf;
-         }
-      }
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return GEOCON_NULL;
    }
 
-   if ( msg_buf == NULL )
+   shm = (GEOCON_SHM *)gc_shm_attach(name, &len);
+   if ( shm == GEOCON_NULL )
    {
-      return "?";
+      *prc = GEOCON_ERR_FILE_NOT_FOUND;
+      return GEOCON_NULL;
    }
-   else
+
+   /* Note that the length of a segment may be rounded up to a page. */
+   if ( len                < sizeof(*shm)                 ||
+        shm->magic        != GEOCON_SHM_MAGIC             )
    {
-      sprintf(msg_buf, "%d", err_num);
-      return msg_buf;
+      gc_unmap_file(shm, len);
+      *prc = GEOCON_ERR_INVALID_FILE;
+      return GEOCON_NULL;
    }
+
+   /* Nothing past the magic number may be read before it is. */
+   gc_shm_barrier();
+
+   if ( shm->hdr_len      != (int)sizeof(shm->hdr)        ||
+        shm->seg_len       > len                          ||
+        (shm->hdr.data_fmt == GEOCON_DATA_QUANT &&
+         !gc_quant_is_valid(&shm->hdr.quant))             ||
+        shm->points_offset + ((size_t)shm->hdr.nrows * shm->hdr.ncols *
+                              gc_point_len(&shm->hdr)) > shm->seg_len )
+   {
+      gc_unmap_file(shm, len);
+      *prc = GEOCON_ERR_INVALID_FILE;
+      return GEOCON_NULL;
+   }
+
+   hdr = geocon_create();
+   if ( hdr == GEOCON_NULL )
+   {
+      gc_unmap_file(shm, len);
+      *prc = GEOCON_ERR_NO_MEMORY;
+      return GEOCON_NULL;
+   }
+
+   *hdr = shm->hdr;
+   hdr->entry    = GEOCON_NULL;
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+      hdr->qpoints = (void *)((char *)shm + shm->points_offset);
+   else
+      hdr->points  = (GEOCON_POINT *)((char *)shm + shm->points_offset);
+   hdr->map_addr = shm;
+   hdr->map_len  = len;
+
+   return hdr;
+#endif
 }
 
 /*------------------------------------------------------------------------
- * create an empty GEOCON header
+ * remove a shared-memory segment
  */
-GEOCON_HDR * geocon_create()
+int geocon_unpublish(
+   const char    *name,
+   int           *prc)
 {
-   GEOCON_HDR * hdr = (GEOCON_HDR *)gc_memalloc(sizeof(*hdr));
+   int gcerr;
 
-   if ( hdr != GEOCON_NULL )
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+#ifdef GEOCON_SHM_NOT_SUPPORTED
+   GEOCON_UNUSED_PARAMETER(name);
+
+   *prc = GEOCON_ERR_NOT_SUPPORTED;
+   return -1;
+#else
+   if ( name == GEOCON_NULL || *name == 0 )
    {
-      memset(hdr, 0, sizeof(*hdr));
-      hdr->fhdr.magic    = GEOCON_HDR_MAGIC;
-      hdr->fhdr.version  = GEOCON_HDR_VERSION;
-      hdr->fhdr.hdrlen   = GEOCON_FILE_HDR_LEN;
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return -1;
    }
 
-   return hdr;
+   if ( gc_shm_remove(name) != 0 )
+   {
+      *prc = GEOCON_ERR_FILE_NOT_FOUND;
+      return -1;
+   }
+
+   return 0;
+#endif
 }
 
 /*------------------------------------------------------------------------
- * load header and optionally the data
+ * write a geocon file
  */
-GEOCON_HDR * geocon_load(
-   const char    *pathname,
-   GEOCON_EXTENT *ext,
-   GEOCON_BOOL    load_data,
-   int           *prc)
+int geocon_write(
+   const GEOCON_HDR *hdr,
+   const char       *pathname,
+   int               byte_order,
+   int              *prc)
 {
-   GEOCON_HDR * hdr;
    int filetype;
    int gcerr;
-   int rc;
 
    if ( prc == GEOCON_NULL )
       prc = &gcerr;
    *prc = GEOCON_ERR_OK;
 
-   if ( pathname == GEOCON_NULL || *pathname == 0 )
+   if ( hdr == GEOCON_NULL || pathname == GEOCON_NULL || *pathname == 0 )
    {
       *prc = GEOCON_ERR_NULL_PARAMETER;
-      return GEOCON_NULL;
+      return -1;
    }
 
    filetype = geocon_filetype(pathname);
    if ( filetype == GEOCON_FILE_TYPE_UNK )
    {
       *prc = GEOCON_ERR_UNKNOWN_FILETYPE;
-      return GEOCON_NULL;
+      return -1;
    }
 
-   hdr = geocon_create();
-   if ( hdr == GEOCON_NULL )
+   if ( gc_load_wait(hdr, prc) != 0 )
+      return -1;
+
+   if ( filetype == GEOCON_FILE_TYPE_BIN )
+      return gc_write_bin(hdr, pathname, byte_order, GEOCON_NULL, 0, 0,
+                          prc);
+   else
+      return gc_write_asc(hdr, pathname,                          prc);
+}
+
+/*------------------------------------------------------------------------
+ * write a quantized geocon file
+ */
+int geocon_write_quant(
+   const GEOCON_HDR *hdr,
+   const char       *pathname,
+   int               byte_order,
+   double            horz_err,
+   double            vert_err,
+   int              *prc)
+{
+   GEOCON_QUANT quant;
+   int gcerr;
+
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+   if ( hdr == GEOCON_NULL || pathname == GEOCON_NULL || *pathname == 0 )
    {
-      *prc = GEOCON_ERR_NO_MEMORY;
-      return GEOCON_NULL;
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return -1;
    }
 
-   hdr->fp = fopen(pathname, "rb");
-   if ( hdr->fp == GEOCON_NULL )
+   if ( geocon_filetype(pathname) != GEOCON_FILE_TYPE_BIN )
    {
-      *prc = GEOCON_ERR_FILE_NOT_FOUND;
-      gc_memdealloc(hdr);
-      return GEOCON_NULL;
+      *prc = GEOCON_ERR_UNKNOWN_FILETYPE;
+      return -1;
    }
 
-   strcpy(hdr->pathname, pathname);
-   hdr->filetype = filetype;
+   if ( gc_load_wait(hdr, prc) != 0 )
+      return -1;
 
-   rc = gc_load_hdr(hdr, prc);
-   if ( rc != 0 )
+   if ( !gc_data_in_memory(hdr) )
    {
-      geocon_delete(hdr);
-      return GEOCON_NULL;
+      *prc = GEOCON_ERR_NO_DATA;
+      return -1;
    }
 
-   if ( load_data )
-   {
-      rc = gc_load_data(hdr, ext, prc);
+   if ( gc_quant_choose(hdr, horz_err, vert_err, &quant, prc) != 0 )
+      return -1;
 
-      /* Done with the file whether there were errors or not. */
-      fclose(hdr->fp);
-      hdr->fp = GEOCON_NULL;
+   return gc_write_bin(hdr, pathname, byte_order, &quant, 0, 0, prc);
+}
 
-      if ( rc != 0 )
-      {
-         geocon_delete(hdr);
-         return GEOCON_NULL;
-      }
+/*------------------------------------------------------------------------
+ * write a packed geocon file
+ */
+int geocon_write_packed(
+   const GEOCON_HDR *hdr,
+   const char       *pathname,
+   int               byte_order,
+   int              *prc)
+{
+   const GEOCON_QUANT * quant = GEOCON_NULL;
+   int gcerr;
+
+   if ( prc == GEOCON_NULL )
+      prc = &gcerr;
+   *prc = GEOCON_ERR_OK;
+
+   if ( hdr == GEOCON_NULL || pathname == GEOCON_NULL || *pathname == 0 )
+   {
+      *prc = GEOCON_ERR_NULL_PARAMETER;
+      return -1;
    }
-   else
+
+   if ( geocon_filetype(pathname) != GEOCON_FILE_TYPE_BIN )
    {
-      if ( hdr->filetype == GEOCON_FILE_TYPE_BIN )
-      {
-         hdr->mutex = (void *)gc_mutex_create();
-      }
-      else
-      {
-         /* No reading on-the-fly if it's an ascii file. */
-         fclose(hdr->fp);
-         hdr->fp = GEOCON_NULL;
-      }
+      *prc = GEOCON_ERR_UNKNOWN_FILETYPE;
+      return -1;
    }
 
-   return hdr;
+   if ( gc_load_wait(hdr, prc) != 0 )
+      return -1;
+
+   if ( !gc_data_in_memory(hdr) )
+   {
+      *prc = GEOCON_ERR_NO_DATA;
+      return -1;
+   }
+
+   /* the points are written in the format they are in */
+
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+      quant = &hdr->quant;
+
+   return gc_write_bin(hdr, pathname, byte_order, quant,
+                       GEOCON_DATA_PACKED, 0, prc);
 }
 
 /*------------------------------------------------------------------------
- * write a geocon file
+ * write a tiled geocon file
  */
-int geocon_write(
+int geocon_write_tiled(
    const GEOCON_HDR *hdr,
    const char       *pathname,
    int               byte_order,
+   int               tile_size,
+   GEOCON_BOOL       packed,
    int              *prc)
 {
-   int filetype;
+   const GEOCON_QUANT * quant = GEOCON_NULL;
+   int flags = GEOCON_DATA_TILED;
    int gcerr;
 
    if ( prc == GEOCON_NULL )
@@ -2174,17 +6938,34 @@ int geocon_write(
       return -1;
    }
 
-   filetype = geocon_filetype(pathname);
-   if ( filetype == GEOCON_FILE_TYPE_UNK )
+   if ( geocon_filetype(pathname) != GEOCON_FILE_TYPE_BIN )
    {
       *prc = GEOCON_ERR_UNKNOWN_FILETYPE;
       return -1;
    }
 
-   if ( filetype == GEOCON_FILE_TYPE_BIN )
-      return gc_write_bin(hdr, pathname, byte_order, prc);
-   else
-      return gc_write_asc(hdr, pathname,             prc);
+   if ( tile_size <= 0 )
+      tile_size = GEOCON_TILE_SIZE;
+
+   if ( packed )
+      flags |= GEOCON_DATA_PACKED;
+
+   if ( gc_load_wait(hdr, prc) != 0 )
+      return -1;
+
+   if ( !gc_data_in_memory(hdr) )
+   {
+      *prc = GEOCON_ERR_NO_DATA;
+      return -1;
+   }
+
+   /* the points are written in the format they are in */
+
+   if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+      quant = &hdr->quant;
+
+   return gc_write_bin(hdr, pathname, byte_order, quant,
+                       flags, tile_size, prc);
 }
 
 /*------------------------------------------------------------------------
@@ -2195,14 +6976,30 @@ void geocon_delete(
 {
    if ( hdr != GEOCON_NULL )
    {
+      if ( hdr->entry != GEOCON_NULL && !gc_registry_release(hdr) )
+         return;
+
+      if ( hdr->loader != GEOCON_NULL )
+      {
+         int rc;
+
+         gc_load_wait(hdr, &rc);
+         gc_loader_delete((GEOCON_LOADER *)hdr->loader);
+      }
+
+      if ( hdr->cache != GEOCON_NULL )
+         gc_cache_delete((GEOCON_CACHE *)hdr->cache);
+
+      if ( hdr->blocks != GEOCON_NULL )
+         gc_blocks_delete((GEOCON_BLOCKS *)hdr->blocks);
+
       if ( hdr->fp != GEOCON_NULL )
          fclose(hdr->fp);
 
       if ( hdr->mutex != GEOCON_NULL )
          gc_mutex_delete(hdr->mutex);
 
-      if ( hdr->points != GEOCON_NULL )
-         gc_memdealloc(hdr->points);
+      gc_free_data(hdr);
 
       gc_memdealloc(hdr);
    }
@@ -2289,6 +7086,34 @@ void geocon_dump_hdr(
       fprintf(fp, "  vert_scale      = %.17g\n",  hdr->fhdr.vert_scale      );
       fprintf(fp, "\n");
 
+      if ( hdr->data_fmt == GEOCON_DATA_QUANT )
+      {
+         static const char * names[3] = { "lat", "lon", "hgt" };
+         int k;
+
+         for (k = 0; k < 3; k++)
+         {
+            fprintf(fp, "  %s_quant       = int%d base %.17g step %.17g"
+                        " max_err %.17g\n",
+               names[k],
+               hdr->quant.size[k] * 8,
+               hdr->quant.base[k],
+               hdr->quant.step[k],
+               hdr->quant.max_err[k]);
+         }
+         fprintf(fp, "\n");
+      }
+
+      if ( (hdr->fhdr.data_fmt & (GEOCON_DATA_PACKED |
+                                  GEOCON_DATA_TILED)) != 0 )
+      {
+         if ( (hdr->fhdr.data_fmt & GEOCON_DATA_PACKED) != 0 )
+            fprintf(fp, "  packed          = yes\n");
+         if ( (hdr->fhdr.data_fmt & GEOCON_DATA_TILED)  != 0 )
+            fprintf(fp, "  tiled           = yes\n");
+         fprintf(fp, "\n");
+      }
+
       fprintf(fp, "  from_gcs        = \"%s\"\n", hdr->fhdr.from_gcs        );
       fprintf(fp, "  from_vcs        = \"%s\"\n", hdr->fhdr.from_vcs        );
       fprintf(fp, "  from_semi_major = %.17g\n",  hdr->fhdr.from_semi_major );
@@ -2310,14 +7135,17 @@ void geocon_dump_data(
    const GEOCON_HDR *hdr,
    FILE             *fp)
 {
-   if ( hdr != GEOCON_NULL && fp != GEOCON_NULL && hdr->points != GEOCON_NULL )
+   int rc;
+
+   if ( hdr != GEOCON_NULL && fp != GEOCON_NULL &&
+        gc_load_wait(hdr, &rc) == 0 && gc_data_in_memory(hdr) )
    {
       int c;
       int r;
 
       for (r = 0; r < hdr->nrows; r++)
       {
-         GEOCON_POINT * p = hdr->points + (r * hdr->ncols);
+         size_t offset = ((size_t)r * hdr->ncols);
          double lat = hdr->lat_min + (r * hdr->lat_delta);
          double lon = hdr->lon_min;
 
@@ -2330,10 +7158,12 @@ void geocon_dump_data(
 
          for (c = 0; c < hdr->ncols; c++)
          {
+            GEOCON_POINT pt;
+
+            gc_get_point(hdr, offset++, &pt);
             fprintf(fp, "%8.3f  %8.3f  %16.9f  %16.9f  %16.9f\n",
-               lat, lon, p->lat_value, p->lon_value, p->hgt_value);
+               lat, lon, pt.lat_value, pt.lon_value, pt.hgt_value);
             lon += hdr->lon_delta;
-            p++;
          }
 
          fprintf(fp, "\n");
@@ -2361,34 +7191,24 @@ int geocon_forward(
       return 0;
    }
 
-   for (i = 0; i < n; i++)
+   if ( !gc_data_ready(hdr) )
    {
-      double lat_deg, lat_shift;
-      double lon_deg, lon_shift;
-      double hgt_mtr, hgt_shift;
-
-      lat_deg =          (coord[i][GEOCON_COORD_LAT] * deg_factor);
-      lon_deg = gc_delta((coord[i][GEOCON_COORD_LON] * deg_factor));
-      hgt_mtr = (h == GEOCON_NULL) ? 0 :       (h[i] * hgt_factor);
-
-      if ( GEOCON_GT(lat_deg, hdr->lat_min_ghost) &&
-           GEOCON_LT(lat_deg, hdr->lat_max_ghost) &&
-           GEOCON_GT(lon_deg, hdr->lon_min_ghost) &&
-           GEOCON_LT(lon_deg, hdr->lon_max_ghost) )
-      {
-         gc_calculate_shifts(hdr, interp, lat_deg, lon_deg,
-            &lat_shift, &lon_shift, &hgt_shift);
-
-         lat_deg += lat_shift;
-         lon_deg += lon_shift;
-         hgt_mtr += hgt_shift;
+      return 0;
+   }
 
-         coord[i][GEOCON_COORD_LAT] = (         lat_deg  / deg_factor);
-         coord[i][GEOCON_COORD_LON] = (gc_delta(lon_deg) / deg_factor);
-         if (h != GEOCON_NULL) h[i] = (         hgt_mtr  / hgt_factor);
+   i = 0;
+#ifdef GEOCON_AVX2
+   if ( gc_batch_avx2(hdr, interp) )
+   {
+      i = gc_forward_avx2(hdr, interp, deg_factor, hgt_factor,
+                          n, coord, h, &num);
+   }
+#endif
 
-         num++;
-      }
+   for (; i < n; i++)
+   {
+      num += gc_forward_point(hdr, interp, deg_factor, hgt_factor,
+                              coord, h, i);
    }
 
    return num;
@@ -2424,6 +7244,11 @@ int geocon_inverse(
       return 0;
    }
 
+   if ( !gc_data_ready(hdr) )
+   {
+      return 0;
+   }
+
    for (i = 0; i < n; i++)
    {
       double lat_deg, lat_next;
@@ -2530,3 +7355,136 @@ int geocon_transform(
    else
       return geocon_inverse(hdr, interp, deg_factor, hgt_factor, n, coord, h);
 }
+
+/*------------------------------------------------------------------------
+ * do a fwd/inv transformation of points using multiple threads
+ *
+ * The points are split into equal parts of at least GEOCON_XFORM_CHUNK_SIZE
+ * points, each of which is transformed by geocon_transform() on its own
+ * thread, either started by us or run by the caller's thread pool.
+ */
+#ifndef   GEOCON_XFORM_CHUNK_SIZE
+#  define GEOCON_XFORM_CHUNK_SIZE  4096  /* min points per thread */
+#endif
+
+typedef struct geocon_xform_task GEOCON_XFORM_TASK;
+struct geocon_xform_task
+{
+   const GEOCON_HDR * hdr;
+   int                interp;
+   double             deg_factor;
+   double             hgt_factor;
+   int                n;            /* number of points in part         */
+   GEOCON_COORD *     coord;        /* first point  of part             */
+   double *           h;            /* first height of part or null     */
+   int                direction;
+   int                num;          /* number of points transformed     */
+};
+
+static void gc_xform_proc(
+   void *arg)
+{
+   GEOCON_XFORM_TASK * task = (GEOCON_XFORM_TASK *)arg;
+
+   task->num = geocon_transform(task->hdr, task->interp,
+                                task->deg_factor, task->hgt_factor,
+                                task->n, task->coord, task->h,
+                                task->direction);
+}
+
+int geocon_transform_mt(
+   const GEOCON_HDR *hdr,
+   int               interp,
+   double            deg_factor,
+   double            hgt_factor,
+   int               n,
+   GEOCON_COORD      coord[],
+   double            h[],
+   int               direction,
+   int               nthreads,
+   GEOCON_POOL_FUNC  pool_func,
+   void *            pool)
+{
+   GEOCON_XFORM_TASK   task_buf[GEOCON_MAX_THREADS];
+   void *              ptr_buf [GEOCON_MAX_THREADS];
+   GEOCON_XFORM_TASK * tasks = task_buf;
+   void **             ptrs  = ptr_buf;
+   int ntasks;
+   int num = 0;
+   int i;
+
+   if ( hdr == GEOCON_NULL || coord == GEOCON_NULL || n <= 0 )
+   {
+      return 0;
+   }
+
+   if ( !gc_data_ready(hdr) )
+   {
+      return 0;
+   }
+
+   /* get the number of parts */
+
+   if ( nthreads <= 0 )
+      nthreads = gc_num_cpus();
+   if ( pool_func == GEOCON_NULL )
+      nthreads = GEOCON_MIN(nthreads, GEOCON_MAX_THREADS);
+
+   ntasks = GEOCON_MIN(n / GEOCON_XFORM_CHUNK_SIZE, nthreads);
+   ntasks = GEOCON_MAX(ntasks, 1);
+
+   if ( ntasks <= 1 )
+   {
+      return geocon_transform(hdr, interp, deg_factor, hgt_factor,
+                              n, coord, h, direction);
+   }
+
+   if ( ntasks > GEOCON_MAX_THREADS )
+   {
+      tasks = (GEOCON_XFORM_TASK *)gc_memalloc(ntasks * sizeof(*tasks));
+      ptrs  = (void **)            gc_memalloc(ntasks * sizeof(*ptrs));
+
+      if ( tasks == GEOCON_NULL || ptrs == GEOCON_NULL )
+      {
+         gc_memdealloc(ptrs);
+         gc_memdealloc(tasks);
+         return geocon_transform(hdr, interp, deg_factor, hgt_factor,
+                                 n, coord, h, direction);
+      }
+   }
+
+   /* split up the points & transform them */
+
+   for (i = 0; i < ntasks; i++)
+   {
+      int beg = (int)(((GEOCON_OFFSET)n *  i     ) / ntasks);
+      int end = (int)(((GEOCON_OFFSET)n * (i + 1)) / ntasks);
+
+      tasks[i].hdr        = hdr;
+      tasks[i].interp     = interp;
+      tasks[i].deg_factor = deg_factor;
+      tasks[i].hgt_factor = hgt_factor;
+      tasks[i].n          = end - beg;
+      tasks[i].coord      = coord + beg;
+      tasks[i].h          = (h == GEOCON_NULL) ? GEOCON_NULL : h + beg;
+      tasks[i].direction  = direction;
+      tasks[i].num        = 0;
+      ptrs[i]             = &tasks[i];
+   }
+
+   if ( pool_func != GEOCON_NULL )
+      pool_func(pool, gc_xform_proc, ptrs, ntasks);
+   else
+      gc_run_parallel(gc_xform_proc, tasks, sizeof(tasks[0]), ntasks);
+
+   for (i = 0; i < ntasks; i++)
+      num += tasks[i].num;
+
+   if ( tasks != task_buf )
+   {
+      gc_memdealloc(ptrs);
+      gc_memdealloc(tasks);
+   }
+
+   return num;
+}
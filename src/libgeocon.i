@@ -174,3 +174,693 @@ static void gc_mutex_delete(void *mp)
       gc_memdealloc(m);
    }
 }
+
+/* ------------------------------------------------------------------------- */
+/* Global lock routines                                                      */
+/* ------------------------------------------------------------------------- */
+
+/* These routines enter and leave a single process-wide lock, which is
+   always there and needs no creating.  It need not be recursive.
+*/
+
+#if defined(GEOCON_NO_MUTEXES)
+
+static void gc_global_lock(void)
+{
+}
+
+static void gc_global_unlock(void)
+{
+}
+
+#elif defined(_WIN32)
+
+static CRITICAL_SECTION gc_global_crit;
+static volatile LONG    gc_global_state = 0;  /* 0=none 1=initing 2=ready */
+
+static void gc_global_lock(void)
+{
+   if ( gc_global_state != 2 )
+   {
+      if ( InterlockedCompareExchange(&gc_global_state, 1, 0) == 0 )
+      {
+         InitializeCriticalSection(&gc_global_crit);
+         InterlockedExchange(&gc_global_state, 2);
+      }
+      else
+      {
+         while ( gc_global_state != 2 )
+            Sleep(0);
+      }
+   }
+
+   EnterCriticalSection(&gc_global_crit);
+}
+
+static void gc_global_unlock(void)
+{
+   LeaveCriticalSection(&gc_global_crit);
+}
+
+#else
+
+static pthread_mutex_t gc_global_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void gc_global_lock(void)
+{
+   pthread_mutex_lock(&gc_global_mutex);
+}
+
+static void gc_global_unlock(void)
+{
+   pthread_mutex_unlock(&gc_global_mutex);
+}
+
+#endif /* OS-specific stuff */
+
+/* ------------------------------------------------------------------------- */
+/* Pathname routines                                                         */
+/* ------------------------------------------------------------------------- */
+
+/* This routine gets the absolute form of a pathname, with any "." and
+   ".." components (and, where supported, symbolic links) resolved, in a
+   buffer of GEOCON_MAX_PATH_LEN chars.  It returns 0 if successful, or
+   -1 if the pathname can't be resolved or is too long.
+*/
+
+#if defined(GEOCON_NO_FULLPATH)
+
+static int gc_full_path(const char *pathname, char *buf)
+{
+   if ( strlen(pathname) >= GEOCON_MAX_PATH_LEN )
+      return -1;
+
+   strcpy(buf, pathname);
+   return 0;
+}
+
+#elif defined(_WIN32)
+
+#  include <stdlib.h>
+
+static int gc_full_path(const char *pathname, char *buf)
+{
+   if ( _fullpath(buf, pathname, GEOCON_MAX_PATH_LEN) == NULL )
+      return -1;
+
+   return 0;
+}
+
+#else
+
+#  include <stdlib.h>
+
+static int gc_full_path(const char *pathname, char *buf)
+{
+   char * path = realpath(pathname, NULL);
+   int    rc   = -1;
+
+   if ( path != NULL )
+   {
+      if ( strlen(path) < GEOCON_MAX_PATH_LEN )
+      {
+         strcpy(buf, path);
+         rc = 0;
+      }
+      free(path);
+   }
+
+   return rc;
+}
+
+#endif /* OS-specific stuff */
+
+/* ------------------------------------------------------------------------- */
+/* File-mapping routines                                                     */
+/* ------------------------------------------------------------------------- */
+
+/* These routines map the first "len" bytes of an open file read-only,
+   and return NULL if the file cannot be mapped.  The mapping remains
+   valid after the stream is closed.
+*/
+
+#if defined(GEOCON_NO_MMAP)
+
+static void * gc_map_file(FILE *fp, size_t len)
+{
+   GEOCON_UNUSED_PARAMETER(fp);
+   GEOCON_UNUSED_PARAMETER(len);
+
+   return GEOCON_NULL;
+}
+
+static void gc_unmap_file(void *addr, size_t len)
+{
+   GEOCON_UNUSED_PARAMETER(addr);
+   GEOCON_UNUSED_PARAMETER(len);
+}
+
+#elif defined(_WIN32)
+
+#  ifndef  WIN32_LEAN_AND_MEAN
+#  define  WIN32_LEAN_AND_MEAN   /* Exclude rarely-used stuff */
+#  endif
+#  include <windows.h>
+#  include <io.h>
+
+static void * gc_map_file(FILE *fp, size_t len)
+{
+   HANDLE fh = (HANDLE)_get_osfhandle(_fileno(fp));
+   HANDLE mh;
+   void * addr;
+
+   if ( fh == INVALID_HANDLE_VALUE )
+      return GEOCON_NULL;
+
+   mh = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+   if ( mh == NULL )
+      return GEOCON_NULL;
+
+   /* The view keeps the mapping object alive after its handle is closed. */
+   addr = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, len);
+   CloseHandle(mh);
+
+   return addr;
+}
+
+static void gc_unmap_file(void *addr, size_t len)
+{
+   GEOCON_UNUSED_PARAMETER(len);
+
+   UnmapViewOfFile(addr);
+}
+
+#else
+
+#  include <sys/mman.h>
+
+static void * gc_map_file(FILE *fp, size_t len)
+{
+   void * addr = mmap(NULL, len, PROT_READ, MAP_SHARED, fileno(fp), 0);
+
+   return (addr == MAP_FAILED) ? GEOCON_NULL : addr;
+}
+
+static void gc_unmap_file(void *addr, size_t len)
+{
+   munmap(addr, len);
+}
+
+#endif /* OS-specific stuff */
+
+/* ------------------------------------------------------------------------- */
+/* Shared-memory routines                                                    */
+/* ------------------------------------------------------------------------- */
+
+/* gc_shm_create() creates a named shared-memory segment of "len" bytes
+   (replacing any existing segment with that name) and maps it read-write.
+   gc_shm_attach() maps an existing segment read-only and returns its
+   length.  Both return NULL if they can't, and their mappings are
+   released with gc_unmap_file().  gc_shm_remove() removes a segment name
+   (any mappings of it stay valid), and returns 0 if it was removed.
+   gc_shm_barrier() is a full memory barrier, which orders the stores of
+   a publisher (or the loads of an attacher) on either side of it.
+
+   Names are as for shm_open(), except that the leading '/' is optional.
+   Segments can only be supported where they persist after the process
+   that created them closes them, so there is no Windows version.  Where
+   they aren't supported, GEOCON_SHM_NOT_SUPPORTED is defined and none of
+   these routines are.
+*/
+
+#if defined(GEOCON_NO_SHM) || defined(GEOCON_NO_MMAP) || defined(_WIN32)
+
+#define GEOCON_SHM_NOT_SUPPORTED
+
+#else
+
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+
+static const char * gc_shm_name(const char *name, char *buf, size_t buflen)
+{
+   if ( *name == '/' )
+      return name;
+
+   if ( strlen(name) + 2 > buflen )
+      return GEOCON_NULL;
+
+   buf[0] = '/';
+   strcpy(buf + 1, name);
+   return buf;
+}
+
+static void * gc_shm_create(const char *name, size_t len)
+{
+   char   buf[GEOCON_MAX_PATH_LEN];
+   void * addr;
+   int    fd;
+
+   name = gc_shm_name(name, buf, sizeof(buf));
+   if ( name == GEOCON_NULL )
+      return GEOCON_NULL;
+
+   /* Replace rather than rewrite any existing segment,
+      since others may have it attached.
+   */
+   shm_unlink(name);
+   fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+   if ( fd < 0 )
+      return GEOCON_NULL;
+
+   if ( ftruncate(fd, (off_t)len) != 0 )
+   {
+      close(fd);
+      shm_unlink(name);
+      return GEOCON_NULL;
+   }
+
+   addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if ( addr == MAP_FAILED )
+   {
+      shm_unlink(name);
+      return GEOCON_NULL;
+   }
+
+   return addr;
+}
+
+static void * gc_shm_attach(const char *name, size_t *plen)
+{
+   char        buf[GEOCON_MAX_PATH_LEN];
+   struct stat st;
+   void *      addr;
+   int         fd;
+
+   name = gc_shm_name(name, buf, sizeof(buf));
+   if ( name == GEOCON_NULL )
+      return GEOCON_NULL;
+
+   fd = shm_open(name, O_RDONLY, 0);
+   if ( fd < 0 )
+      return GEOCON_NULL;
+
+   if ( fstat(fd, &st) != 0 || st.st_size <= 0 )
+   {
+      close(fd);
+      return GEOCON_NULL;
+   }
+
+   addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if ( addr == MAP_FAILED )
+      return GEOCON_NULL;
+
+   *plen = (size_t)st.st_size;
+   return addr;
+}
+
+static void gc_shm_barrier(void)
+{
+#if defined(__GNUC__)
+   __sync_synchronize();
+#else
+   /* Locking and unlocking a mutex synchronizes memory (POSIX 4.12). */
+   gc_global_lock();
+   gc_global_unlock();
+#endif
+}
+
+static int gc_shm_remove(const char *name)
+{
+   char buf[GEOCON_MAX_PATH_LEN];
+
+   name = gc_shm_name(name, buf, sizeof(buf));
+   if ( name == GEOCON_NULL )
+      return -1;
+
+   return shm_unlink(name);
+}
+
+#endif /* OS-specific stuff */
+
+/* ------------------------------------------------------------------------- */
+/* File-offset routines                                                      */
+/* ------------------------------------------------------------------------- */
+
+/* These routines are ftell() and fseek() with 64-bit offsets, so that
+   files larger than 2GB can be read even where a long is 32 bits.
+*/
+
+#if defined(_MSC_VER)
+
+static GEOCON_OFFSET gc_ftell(FILE *fp)
+{
+   return _ftelli64(fp);
+}
+
+static int gc_fseek(FILE *fp, GEOCON_OFFSET offset, int whence)
+{
+   return _fseeki64(fp, offset, whence);
+}
+
+#elif defined(GEOCON_NO_FSEEKO) || defined(_WIN32)
+
+static GEOCON_OFFSET gc_ftell(FILE *fp)
+{
+   return (GEOCON_OFFSET)ftell(fp);
+}
+
+static int gc_fseek(FILE *fp, GEOCON_OFFSET offset, int whence)
+{
+   return fseek(fp, (long)offset, whence);
+}
+
+#else
+
+static GEOCON_OFFSET gc_ftell(FILE *fp)
+{
+   return (GEOCON_OFFSET)ftello(fp);
+}
+
+static int gc_fseek(FILE *fp, GEOCON_OFFSET offset, int whence)
+{
+   return fseeko(fp, (off_t)offset, whence);
+}
+
+#endif /* OS-specific stuff */
+
+/* ------------------------------------------------------------------------- */
+/* Positional read routines                                                  */
+/* ------------------------------------------------------------------------- */
+
+/* This routine reads "len" bytes at a given offset in an open file,
+   without using or changing the position of the stream, and returns
+   0 if all the bytes were read.  It may be called by multiple threads
+   at once, unless GEOCON_READ_AT_NEEDS_LOCK is defined.
+*/
+
+#if defined(GEOCON_NO_PREAD)
+
+/* Note that this version is not thread-safe. */
+#define GEOCON_READ_AT_NEEDS_LOCK
+
+static int gc_read_at(FILE *fp, void *buf, size_t len,
+                      GEOCON_OFFSET offset)
+{
+   if ( gc_fseek(fp, offset, SEEK_SET) != 0 )
+      return -1;
+
+   return ( fread(buf, 1, len, fp) == len ) ? 0 : -1;
+}
+
+#elif defined(_WIN32)
+
+#  ifndef  WIN32_LEAN_AND_MEAN
+#  define  WIN32_LEAN_AND_MEAN   /* Exclude rarely-used stuff */
+#  endif
+#  include <windows.h>
+#  include <io.h>
+
+static int gc_read_at(FILE *fp, void *buf, size_t len,
+                      GEOCON_OFFSET offset)
+{
+   HANDLE     fh = (HANDLE)_get_osfhandle(_fileno(fp));
+   OVERLAPPED ov;
+   DWORD      nr;
+
+   memset(&ov, 0, sizeof(ov));
+   ov.Offset     = (DWORD)(offset & 0xffffffff);
+   ov.OffsetHigh = (DWORD)(offset >> 32);
+
+   if ( !ReadFile(fh, buf, (DWORD)len, &nr, &ov) || nr != (DWORD)len )
+      return -1;
+
+   return 0;
+}
+
+#else
+
+#  include <unistd.h>
+#  include <errno.h>
+
+static int gc_read_at(FILE *fp, void *buf, size_t len,
+                      GEOCON_OFFSET offset)
+{
+   int    fd = fileno(fp);
+   char * p  = (char *)buf;
+
+   while ( len > 0 )
+   {
+      ssize_t n = pread(fd, p, len, (off_t)offset);
+
+      if ( n <= 0 )
+      {
+         if ( n < 0 && errno == EINTR )
+            continue;
+         return -1;
+      }
+
+      p      += n;
+      len    -= (size_t)n;
+      offset += (GEOCON_OFFSET)n;
+   }
+
+   return 0;
+}
+
+#endif /* OS-specific stuff */
+
+/* ------------------------------------------------------------------------- */
+/* Thread routines                                                           */
+/* ------------------------------------------------------------------------- */
+
+/* gc_thread_create() starts a thread running func(arg), and returns a
+   handle to it or NULL if it can't (in which case the caller should just
+   call func(arg) itself).  gc_thread_join() waits for a thread to finish
+   and deletes its handle.  gc_num_cpus() returns the number of CPUs
+   available.
+*/
+
+typedef void (*GEOCON_THREAD_FUNC)(void *arg);
+
+#if defined(GEOCON_NO_THREADS) || defined(GEOCON_NO_MUTEXES)
+
+static void * gc_thread_create(GEOCON_THREAD_FUNC func, void *arg)
+{
+   GEOCON_UNUSED_PARAMETER(func);
+   GEOCON_UNUSED_PARAMETER(arg);
+
+   return GEOCON_NULL;
+}
+
+static void gc_thread_join(void *tp)
+{
+   GEOCON_UNUSED_PARAMETER(tp);
+}
+
+static int gc_num_cpus(void)
+{
+   return 1;
+}
+
+#elif defined(_WIN32)
+
+#  ifndef  WIN32_LEAN_AND_MEAN
+#  define  WIN32_LEAN_AND_MEAN   /* Exclude rarely-used stuff */
+#  endif
+#  include <windows.h>
+#  include <process.h>
+
+typedef struct geocon_thread_t GEOCON_THREAD_T;
+struct geocon_thread_t
+{
+   HANDLE               handle;
+   GEOCON_THREAD_FUNC   func;
+   void *               arg;
+};
+
+static unsigned __stdcall gc_thread_start(void *tp)
+{
+   GEOCON_THREAD_T * t = (GEOCON_THREAD_T *)tp;
+
+   t->func(t->arg);
+   return 0;
+}
+
+static void * gc_thread_create(GEOCON_THREAD_FUNC func, void *arg)
+{
+   GEOCON_THREAD_T * t = (GEOCON_THREAD_T *)gc_memalloc(sizeof(*t));
+
+   if ( t != GEOCON_NULL )
+   {
+      t->func   = func;
+      t->arg    = arg;
+      t->handle = (HANDLE)_beginthreadex(NULL, 0, gc_thread_start, t, 0, NULL);
+      if ( t->handle == 0 )
+      {
+         gc_memdealloc(t);
+         t = GEOCON_NULL;
+      }
+   }
+
+   return (void *)t;
+}
+
+static void gc_thread_join(void *tp)
+{
+   GEOCON_THREAD_T * t = (GEOCON_THREAD_T *)tp;
+
+   if ( t != GEOCON_NULL )
+   {
+      WaitForSingleObject(t->handle, INFINITE);
+      CloseHandle(t->handle);
+      gc_memdealloc(t);
+   }
+}
+
+static int gc_num_cpus(void)
+{
+   SYSTEM_INFO si;
+
+   GetSystemInfo(&si);
+   return (int)si.dwNumberOfProcessors;
+}
+
+#else
+
+#  include <pthread.h>
+#  include <unistd.h>
+
+typedef struct geocon_thread_t GEOCON_THREAD_T;
+struct geocon_thread_t
+{
+   pthread_t            thread;
+   GEOCON_THREAD_FUNC   func;
+   void *               arg;
+};
+
+static void * gc_thread_start(void *tp)
+{
+   GEOCON_THREAD_T * t = (GEOCON_THREAD_T *)tp;
+
+   t->func(t->arg);
+   return NULL;
+}
+
+static void * gc_thread_create(GEOCON_THREAD_FUNC func, void *arg)
+{
+   GEOCON_THREAD_T * t = (GEOCON_THREAD_T *)gc_memalloc(sizeof(*t));
+
+   if ( t != GEOCON_NULL )
+   {
+      t->func = func;
+      t->arg  = arg;
+      if ( pthread_create(&t->thread, NULL, gc_thread_start, t) != 0 )
+      {
+         gc_memdealloc(t);
+         t = GEOCON_NULL;
+      }
+   }
+
+   return (void *)t;
+}
+
+static void gc_thread_join(void *tp)
+{
+   GEOCON_THREAD_T * t = (GEOCON_THREAD_T *)tp;
+
+   if ( t != GEOCON_NULL )
+   {
+      pthread_join(t->thread, NULL);
+      gc_memdealloc(t);
+   }
+}
+
+static int gc_num_cpus(void)
+{
+   long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+   return (n < 1) ? 1 : (int)n;
+}
+
+#endif /* OS-specific stuff */
+
+/* ------------------------------------------------------------------------- */
+/* SIMD routines                                                             */
+/* ------------------------------------------------------------------------- */
+
+/* If GEOCON_AVX2 is defined, the transform routines have batch versions
+   that use AVX2 instructions.  These are compiled for AVX2 (by marking
+   them with GEOCON_AVX2_FUNC) whatever the compiler options are, and are
+   only used if gc_cpu_has_avx2() says that the CPU (and OS) support it.
+   Define GEOCON_NO_SIMD to leave them out.  With MSVC, they need VS2012
+   or later, since VS2010's <immintrin.h> only has the AVX intrinsics.
+
+   gc_cpu_has_avx2() is called for every batch, by any number of threads
+   at once, so it must be cheap and thread-safe.
+*/
+
+#if defined(GEOCON_NO_SIMD)
+
+/* no SIMD routines */
+
+#elif defined(_MSC_VER) && defined(_M_X64) && (_MSC_VER >= 1700)
+
+#  define GEOCON_AVX2
+#  define GEOCON_AVX2_FUNC
+#  include <immintrin.h>
+#  include <intrin.h>
+
+static int gc_cpu_check_avx2(void)
+{
+   int r[4];
+
+   __cpuid(r, 0);
+   if ( r[0] < 7 )
+      return FALSE;
+
+   /* check for AVX & that the OS saves the YMM registers */
+   __cpuid(r, 1);
+   if ( (r[2] & (1 << 27)) == 0 || (r[2] & (1 << 28)) == 0 ||
+        (_xgetbv(0) & 6) != 6 )
+      return FALSE;
+
+   __cpuidex(r, 7, 0);
+   return (r[1] & (1 << 5)) != 0;
+}
+
+static int gc_cpu_has_avx2(void)
+{
+   /* cpuid is slow (especially in a VM), so its answer is kept.
+      Threads that race to set it all set the same value. */
+   static volatile LONG gc_avx2_state = 0;  /* 0=unknown 1=no 2=yes */
+
+   if ( gc_avx2_state == 0 )
+      InterlockedExchange(&gc_avx2_state, gc_cpu_check_avx2() ? 2 : 1);
+
+   return gc_avx2_state == 2;
+}
+
+#elif defined(__x86_64__) &&                                  \
+      (defined(__clang__) ||                                    \
+       (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+
+#  define GEOCON_AVX2
+#  define GEOCON_AVX2_FUNC  __attribute__((target("avx2")))
+#  include <immintrin.h>
+
+/* The CPU model is filled in by a constructor before main() (and
+   __builtin_cpu_init() does nothing if it has been), so this just reads
+   a flag.
+*/
+static int gc_cpu_has_avx2(void)
+{
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2") != 0;
+}
+
+#endif /* compiler-specific stuff */